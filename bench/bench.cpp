@@ -0,0 +1,241 @@
+// File: bench/bench.cpp
+// Benchmark harness for the JSON/TXT/XML parsers and the FROM/TO date filters.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../server/parser/json_parser.hpp"
+#include "../server/parser/txt_parser.hpp"
+#include "../server/parser/xml_parser.hpp"
+#include "../server/parser/bin_parser.hpp"
+#include "../server/parser/date_filter.hpp"
+#include "../server/parser/lib/nlohmann/json.hpp"
+#include "../server/metrics/perf_counters.hpp"
+#include "../generator/log_generator.hpp"
+
+// The benchmark always counts allocations, with the same hook the server uses
+#ifndef ALLOC_STATS
+#define ALLOC_STATS 1
+#endif
+#include "../server/metrics/alloc_stats.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+// ---- Peak RSS ----------------------------------------------------------------
+
+// Reset the kernel's resident-set high-water mark (Linux 4.0+); no-op elsewhere
+static void resetPeakRss() {
+    if (FILE* f = fopen("/proc/self/clear_refs", "w")) {
+        fputs("5", f);
+        fclose(f);
+    }
+}
+
+// Peak resident set in KB since the last reset (VmHWM), or since start (getrusage)
+static long peakRssKb() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return atol(line.c_str() + 6);
+    }
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// ---- Harness -----------------------------------------------------------------
+
+struct BenchCase {
+    string name;
+    const string* input;
+    function<size_t()> run;   ///< Returns a result size so the work is not optimised away
+};
+
+struct Options {
+    vector<size_t>   records       = {10000, 100000};
+    vector<uint32_t> cardinalities = {100, 10000};
+    double zipf   = 1.0;
+    int    reps   = 5;
+    bool   asJson = false;
+    bool   perf   = false;                         ///< Hardware counters per case
+    string only;                                   ///< Comma list of case names, "" = all
+};
+
+template <typename T>
+static vector<T> parseList(const string& s) {
+    vector<T> out;
+    istringstream is(s);
+    string item;
+    while (getline(is, item, ',')) {
+        if (!item.empty()) out.push_back(static_cast<T>(stoull(item)));
+    }
+    return out;
+}
+
+static void usage() {
+    cerr << "Usage: bench_app [--records N,N,...] [--users N,N,...] [--zipf S] [--reps N] [--only CASE,...] [--json] [--perf]\n"
+         << "Cases: json_parse txt_parse xml_parse bin_parse json_filter txt_filter xml_filter\n";
+}
+
+/**
+ * Runs one case: a warm-up pass, then `reps` timed passes. The median time
+ * gives the throughput figures; allocations are counted on the last pass.
+ * With perf counters, they are summed over the timed passes (outside the
+ * clock) and reported per record.
+ */
+static json measure(const BenchCase& bc, size_t records, uint32_t users, double zipf, int reps,
+                    PerfCounters* perf) {
+    size_t sink = bc.run();  // warm-up
+    resetPeakRss();
+    vector<double> secs;
+    AllocCounts allocs;
+    PerfSample counters;
+    for (int r = 0; r < reps; ++r) {
+        AllocCounts before = threadAllocs();
+        if (perf) perf->start();
+        auto t0 = chrono::steady_clock::now();
+        sink += bc.run();
+        secs.push_back(chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+        if (perf) counters += perf->stop();
+        allocs = threadAllocs() - before;
+    }
+    sort(secs.begin(), secs.end());
+    double median = secs[(secs.size() - 1) / 2];
+    double mb     = bc.input->size() / 1e6;
+    json r = {
+        {"case", bc.name}, {"records", records}, {"users", users}, {"zipf", zipf},
+        {"bytes", bc.input->size()}, {"reps", reps},
+        {"median_s", median}, {"min_s", secs.front()}, {"max_s", secs.back()},
+        {"mb_per_s", median > 0 ? mb / median : 0.0},
+        {"records_per_s", median > 0 ? records / median : 0.0},
+        {"allocs_per_record", records ? double(allocs.count) / records : 0.0},
+        {"alloc_bytes_per_record", records ? double(allocs.bytes) / records : 0.0},
+        {"peak_rss_kb", peakRssKb()},
+        {"checksum", sink},
+    };
+    if (perf) {
+        double perRecord = records ? 1.0 / (double(records) * reps) : 0.0;
+        r["ipc"]                      = counters.ipc();
+        r["cycles_per_record"]        = counters.cycles * perRecord;
+        r["instructions_per_record"]  = counters.instructions * perRecord;
+        r["cache_misses_per_record"]  = counters.cacheMisses * perRecord;
+        r["branch_misses_per_record"] = counters.branchMisses * perRecord;
+    }
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--records" && hasValue)    opt.records       = parseList<size_t>(argv[++i]);
+        else if (arg == "--users" && hasValue) opt.cardinalities = parseList<uint32_t>(argv[++i]);
+        else if (arg == "--zipf" && hasValue)  opt.zipf          = max(0.0, atof(argv[++i]));
+        else if (arg == "--reps" && hasValue)  opt.reps          = max(1, atoi(argv[++i]));
+        else if (arg == "--only" && hasValue)  opt.only          = "," + string(argv[++i]) + ",";
+        else if (arg == "--json")              opt.asJson        = true;
+        else if (arg == "--perf")              opt.perf          = true;
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (opt.records.empty() || opt.cardinalities.empty() ||
+        any_of(opt.cardinalities.begin(), opt.cardinalities.end(), [](uint32_t c) { return c == 0; })) {
+        usage();
+        return 1;
+    }
+
+    // Generated logs cover 2024-09-01 .. 2024-09-30; FROM/TO keep the middle half
+    const string fromDate = "2024-09-08", toDate = "2024-09-22";
+
+    // Counters follow this thread, which runs every case
+    PerfCounters counters;
+    PerfCounters* perf = nullptr;
+    if (opt.perf) {
+        string err;
+        if (counters.open(err)) perf = &counters;
+        else cerr << "[WARN] Hardware counters unavailable (" << err << "), running without --perf\n";
+    }
+
+    json results = json::array();
+    if (!opt.asJson) {
+        printf("%-12s %9s %7s %9s %10s %12s %10s %11s %10s", "case", "records", "users", "MB",
+               "MB/s", "records/s", "allocs/rec", "allocB/rec", "peakRSS_KB");
+        if (perf) printf(" %6s %9s %9s %9s", "IPC", "cyc/rec", "llc/rec", "brm/rec");
+        printf("\n");
+    }
+    for (size_t records : opt.records) {
+        for (uint32_t users : opt.cardinalities) {
+            GeneratorConfig cfg;
+            cfg.records = records;
+            cfg.users   = users;
+            cfg.ips     = users;
+            cfg.zipf    = opt.zipf;
+            cfg.seed    = 42;
+            const string txt = LogGenerator(cfg, FileType::TXT).renderAll();
+            const string jsn = LogGenerator(cfg, FileType::JSON).renderAll();
+            const string xml = LogGenerator(cfg, FileType::XML).renderAll();
+
+            // The same records as a converted PLOGBIN file, read back through the
+            // mmap path (BINParser::openFile) on every run
+            BinWriter writer;
+            TXTParser(txt).forEachRecord([&](const LogRecord& rec) { writer.add(rec); });
+            const string bin = writer.finish();
+            const string binPath = (filesystem::temp_directory_path() /
+                                    ("bench_app_" + to_string(getpid()) + ".plogbin")).string();
+            ofstream(binPath, ios::out | ios::binary | ios::trunc).write(bin.data(), static_cast<streamsize>(bin.size()));
+
+            const vector<BenchCase> cases = {
+                {"json_parse",  &jsn, [&] { return JSONParser(jsn).parse(AnalysisType::BY_USER).size(); }},
+                {"txt_parse",   &txt, [&] { return TXTParser(txt).parse(AnalysisType::BY_USER).size(); }},
+                {"xml_parse",   &xml, [&] { return XMLParser(xml).parse(AnalysisType::BY_USER).size(); }},
+                {"bin_parse",   &bin, [&] {
+                    auto parser = BINParser::openFile(binPath);
+                    return parser ? parser->parse(AnalysisType::BY_USER).size() : 0;
+                }},
+                {"json_filter", &jsn, [&] { return filterJsonByDate(jsn, fromDate, toDate).size(); }},
+                {"txt_filter",  &txt, [&] { return filterTxtByDate(txt, fromDate, toDate).size(); }},
+                {"xml_filter",  &xml, [&] { return filterXmlByDate(xml, fromDate, toDate).size(); }},
+            };
+            for (const auto& bc : cases) {
+                if (!opt.only.empty() && opt.only.find("," + bc.name + ",") == string::npos) continue;
+                json r = measure(bc, records, users, opt.zipf, opt.reps, perf);
+                if (!opt.asJson) {
+                    printf("%-12s %9zu %7u %9.1f %10.1f %12.0f %10.2f %11.1f %10ld", bc.name.c_str(), records,
+                           users, bc.input->size() / 1e6, r["mb_per_s"].get<double>(),
+                           r["records_per_s"].get<double>(), r["allocs_per_record"].get<double>(),
+                           r["alloc_bytes_per_record"].get<double>(), r["peak_rss_kb"].get<long>());
+                    if (perf) {
+                        printf(" %6.2f %9.0f %9.2f %9.2f", r["ipc"].get<double>(),
+                               r["cycles_per_record"].get<double>(), r["cache_misses_per_record"].get<double>(),
+                               r["branch_misses_per_record"].get<double>());
+                    }
+                    printf("\n");
+                    fflush(stdout);
+                }
+                results.push_back(move(r));
+            }
+            filesystem::remove(binPath);
+        }
+    }
+    if (opt.asJson) {
+        json doc = {{"benchmark", "parsers"}, {"reps", opt.reps}, {"perf", perf != nullptr},
+                    {"results", results}};
+        cout << doc.dump(2) << "\n";
+    }
+    return 0;
+}
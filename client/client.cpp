@@ -5,11 +5,21 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <filesystem>
 #include <regex>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <csignal>
+#include <cerrno>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "load_test.hpp"
+#include "../server/util/xxhash64.hpp"
 
 #define BUFFER_SIZE 8192
 
@@ -26,13 +36,12 @@ bool readFile(const string& path, string& out) {
     return true;
 }
 
-// Send a single payload and print the result
-void sendAndReceive(const string& serverIp, int serverPort,
-                    const string& payload, const string& filename) {
+// Open a TCP connection to the server; returns the socket or -1 after reporting the error
+int connectTo(const string& serverIp, int serverPort, const string& filename) {
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock < 0) {
         cerr << "[ERROR] Failed to create socket for file " << filename << "\n";
-        return;
+        return -1;
     }
     sockaddr_in servAddr{};
     servAddr.sin_family = AF_INET;
@@ -40,39 +49,440 @@ void sendAndReceive(const string& serverIp, int serverPort,
     if (inet_pton(AF_INET, serverIp.c_str(), &servAddr.sin_addr) <= 0) {
         cerr << "[ERROR] Invalid server IP: " << serverIp << " for file " << filename << "\n";
         close(sock);
-        return;
+        return -1;
     }
     if (connect(sock, (sockaddr*)&servAddr, sizeof(servAddr)) < 0) {
         cerr << "[ERROR] Connection to server failed for file " << filename << "\n";
         close(sock);
-        return;
+        return -1;
+    }
+    return sock;
+}
+
+// Send the whole buffer, retrying on partial writes
+bool sendAll(int sock, const char* data, size_t size, const string& filename) {
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = send(sock, data + sent, size - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            cerr << "[ERROR] Only sent " << sent << " of " << size
+                      << " bytes for file " << filename << "\n";
+            return false;
+        }
+        sent += static_cast<size_t>(n);
     }
-    
+    return true;
+}
+
+// Send a single payload and collect the full response; false on any socket error
+bool exchange(const string& serverIp, int serverPort,
+              const string& payload, const string& filename, string& response) {
+    int sock = connectTo(serverIp, serverPort, filename);
+    if (sock < 0) return false;
+
     // Send payload
-    ssize_t sent = send(sock, payload.c_str(), payload.size(), 0);
-    if (sent != static_cast<ssize_t>(payload.size())) {
-        cerr << "[ERROR] Only sent " << sent << " of " << payload.size()
-                  << " bytes for file " << filename << "\n";
+    if (!sendAll(sock, payload.data(), payload.size(), filename)) {
         close(sock);
-        return;
+        return false;
     }
     shutdown(sock, SHUT_WR);  // signal EOF
 
-    // Receive and print
-    cout << "\n=== Analysis Result for " << filename << " ===\n";
+    // Receive everything until the server closes
+    response.clear();
     char buffer[BUFFER_SIZE];
     ssize_t received;
-    while ((received = recv(sock, buffer, BUFFER_SIZE - 1, 0)) > 0) {
-        buffer[received] = '\0';
-        cout << buffer;
+    while ((received = recv(sock, buffer, BUFFER_SIZE, 0)) > 0) {
+        response.append(buffer, received);
     }
+    close(sock);
+    return true;
+}
+
+// Send a single payload and print the result
+void sendAndReceive(const string& serverIp, int serverPort,
+                    const string& payload, const string& filename) {
+    string response;
+    if (!exchange(serverIp, serverPort, payload, filename, response)) return;
+    cout << "\n=== Analysis Result for " << filename << " ===\n";
+    cout << response;
     cout << "=== End of " << filename << " ===\n";
+}
+
+// Incremental state file kept next to the logs: one "key<TAB>offset<TAB>hash" line per file/query
+const char* STATE_FILE = ".incremental_state";
+
+unordered_map<string, pair<uint64_t, string>> loadIncrementalState(const string& dirPath) {
+    unordered_map<string, pair<uint64_t, string>> state;
+    ifstream ifs(fs::path(dirPath) / STATE_FILE);
+    string line;
+    while (getline(ifs, line)) {
+        size_t t1 = line.find('\t');
+        size_t t2 = line.find('\t', t1 == string::npos ? t1 : t1 + 1);
+        if (t2 == string::npos) continue;
+        state[line.substr(0, t1)] = {strtoull(line.c_str() + t1 + 1, nullptr, 10), line.substr(t2 + 1)};
+    }
+    return state;
+}
+
+void saveIncrementalState(const string& dirPath,
+                          const unordered_map<string, pair<uint64_t, string>>& state) {
+    ofstream ofs(fs::path(dirPath) / STATE_FILE, ios::trunc);
+    for (const auto& kv : state) {
+        ofs << kv.first << '\t' << kv.second.first << '\t' << kv.second.second << '\n';
+    }
+}
+
+/**
+ * XXH64 of the first n bytes of the local file, in the hex form the server
+ * uses for PREFIX_HASH. Empty if the file has fewer than n bytes.
+ */
+string hashFilePrefix(const fs::path& path, uint64_t n) {
+    ifstream ifs(path, ios::in | ios::binary);
+    XXHash64 hash;
+    vector<char> buf(1 << 20);
+    while (n > 0) {
+        size_t want = static_cast<size_t>(min<uint64_t>(n, buf.size()));
+        if (!ifs.read(buf.data(), static_cast<streamsize>(want))) return "";
+        hash.update(buf.data(), want);
+        n -= want;
+    }
+    ostringstream os;
+    os << hex << hash.digest();
+    return os.str();
+}
+
+/**
+ * Sends only the bytes appended to a TXT log since the last run (up to the last
+ * complete line) and prints the merged totals returned by the server.
+ * PREFIX_HASH is computed from the local file's first OFFSET bytes, so a file
+ * that was replaced by different content is noticed even if it is as long.
+ * Falls back to sending the whole file when that hash no longer matches the
+ * one the server returned last time, when the server asks to RESYNC, or when
+ * the file shrank (rotation/truncation).
+ */
+void sendIncremental(const string& serverIp, int serverPort, const fs::path& path,
+                     const string& analysis, const string& fromDate, const string& toDate,
+                     unordered_map<string, pair<uint64_t, string>>& state) {
+    string filename = path.filename().string();
+    string fileId   = fs::absolute(path).string();
+    string key      = fileId + "|" + analysis + "|" + fromDate + "|" + toDate;
+
+    uint64_t offset = 0;
+    string prefixHash = "0";
+    auto it = state.find(key);
+    if (it != state.end() && it->second.first <= fs::file_size(path)) {
+        string local = hashFilePrefix(path, it->second.first);
+        if (local == it->second.second) {
+            offset     = it->second.first;
+            prefixHash = local;
+        }
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        ifstream ifs(path, ios::in | ios::binary);
+        if (!ifs.is_open()) {
+            cerr << "[ERROR] Cannot open log file: " << path << "\n";
+            return;
+        }
+        ifs.seekg(static_cast<streamoff>(offset));
+        ostringstream tailStream;
+        tailStream << ifs.rdbuf();
+        string tail = tailStream.str();
+        // Only complete lines; a partially written last line is sent next time
+        size_t lastNl = tail.rfind('\n');
+        tail.resize(lastNl == string::npos ? 0 : lastNl + 1);
+
+        ostringstream msg;
+        msg << "CMD:APPEND\n";
+        msg << "FILE:" << fileId << "\n";
+        msg << "OFFSET:" << offset << "\n";
+        msg << "PREFIX_HASH:" << prefixHash << "\n";
+        msg << "TYPE:" << analysis << "\n";
+        if (!fromDate.empty()) msg << "FROM:" << fromDate << "\n";
+        if (!toDate.empty())   msg << "TO:"   << toDate   << "\n";
+        msg << "\n";
+        msg << tail;
+
+        string response;
+        if (!exchange(serverIp, serverPort, msg.str(), filename, response)) return;
+        if (response.rfind("RESYNC", 0) == 0) {
+            offset = 0;
+            prefixHash = "0";
+            continue;
+        }
+        size_t sep = response.find("\n\n");
+        if (response.rfind("OFFSET:", 0) != 0 || sep == string::npos) {
+            cout << "\n=== Analysis Result for " << filename << " ===\n" << response
+                 << "=== End of " << filename << " ===\n";
+            return;
+        }
+        istringstream hs(response.substr(0, sep));
+        string line;
+        while (getline(hs, line)) {
+            if (line.rfind("OFFSET:", 0) == 0)           offset = stoull(line.substr(7));
+            else if (line.rfind("PREFIX_HASH:", 0) == 0) prefixHash = line.substr(12);
+        }
+        state[key] = {offset, prefixHash};
+        cout << "\n=== Analysis Result for " << filename << " (sent " << tail.size()
+             << " new bytes) ===\n" << response.substr(sep + 2)
+             << "=== End of " << filename << " ===\n";
+        return;
+    }
+    cerr << "[ERROR] Server kept requesting resync for " << filename << "\n";
+}
+
+// Set by SIGINT/SIGTERM to end a follow session cleanly
+volatile sig_atomic_t stopFollowing = 0;
+
+/**
+ * Follow mode: tails a TXT log (inotify) and streams each batch of appended
+ * complete lines to the server over one persistent CMD:FOLLOW connection,
+ * printing the running totals whenever the server pushes a DELTA block.
+ * Truncation and rotation (file moved/deleted and recreated) restart reading
+ * from the beginning of the new file. Ctrl-C half-closes the connection and
+ * prints the server's final TOTAL block.
+ */
+int followFile(const string& serverIp, int serverPort, const string& path,
+               const string& analysis, int intervalMs, uint64_t batch, bool fromStart) {
+    string filename = fs::path(path).filename().string();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "[ERROR] Cannot open log file: " << path << "\n";
+        return 1;
+    }
+    off_t pos = fromStart ? 0 : lseek(fd, 0, SEEK_END);
+
+    int notifyFd = inotify_init1(IN_NONBLOCK);
+    const uint32_t watchMask = IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF | IN_ATTRIB;
+    int watch = notifyFd < 0 ? -1 : inotify_add_watch(notifyFd, path.c_str(), watchMask);
+    if (watch < 0) {
+        cerr << "[WARN] inotify unavailable, polling " << path << " every second\n";
+    }
+
+    int sock = connectTo(serverIp, serverPort, filename);
+    if (sock < 0) {
+        close(fd);
+        return 1;
+    }
+    ostringstream hdr;
+    hdr << "CMD:FOLLOW\n";
+    hdr << "TYPE:" << analysis << "\n";
+    hdr << "INTERVAL_MS:" << intervalMs << "\n";
+    hdr << "BATCH:" << batch << "\n";
+    hdr << "\n";
+    string header = hdr.str();
+    if (!sendAll(sock, header.data(), header.size(), filename)) {
+        close(sock);
+        close(fd);
+        return 1;
+    }
+
+    signal(SIGINT,  [](int) { stopFollowing = 1; });
+    signal(SIGTERM, [](int) { stopFollowing = 1; });
+    cout << "[INFO] Following " << path << " (Ctrl-C to stop)\n";
+
+    unordered_map<string, long long> totals;
+    string partial;   // bytes after the last newline, sent once the line completes
+    string inbox;     // server pushes not yet printed
+    char buffer[BUFFER_SIZE];
+
+    // Ship whatever complete lines were appended since pos
+    auto shipNewLines = [&]() {
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) return true;
+        if (st.st_size < pos) {
+            cout << "[INFO] " << filename << " was truncated, restarting from the top\n";
+            pos = 0;
+            partial.clear();
+        }
+        ssize_t n;
+        while ((n = pread(fd, buffer, sizeof(buffer), pos)) > 0) {
+            pos += n;
+            partial.append(buffer, static_cast<size_t>(n));
+            size_t lastNl = partial.rfind('\n');
+            if (lastNl == string::npos) continue;
+            if (!sendAll(sock, partial.data(), lastNl + 1, filename)) return false;
+            partial.erase(0, lastNl + 1);
+        }
+        return true;
+    };
+    // Reopen path after rotation; the new file is read from its start
+    auto reopen = [&]() {
+        int newFd = open(path.c_str(), O_RDONLY);
+        if (newFd < 0) return;
+        if (fd >= 0) {
+            shipNewLines();  // drain what the old file still holds
+            close(fd);
+        }
+        fd = newFd;
+        pos = 0;
+        partial.clear();
+        if (notifyFd >= 0) {
+            if (watch >= 0) inotify_rm_watch(notifyFd, watch);
+            watch = inotify_add_watch(notifyFd, path.c_str(), watchMask);
+        }
+        cout << "[INFO] " << filename << " was rotated, following the new file\n";
+    };
+    // Print every complete "DELTA ..." / "TOTAL ..." block received so far
+    auto printPushes = [&]() {
+        size_t end;
+        while ((end = inbox.find("\n\n")) != string::npos) {
+            istringstream block(inbox.substr(0, end + 1));
+            inbox.erase(0, end + 2);
+            string head, line;
+            getline(block, head);
+            if (head.rfind("TOTAL", 0) == 0) {
+                cout << "\n=== Final totals for " << filename << " (" << head.substr(6)
+                     << " records) ===\n";
+                while (getline(block, line)) cout << line << "\n";
+                cout << "=== End of " << filename << " ===\n";
+                continue;
+            }
+            istringstream hs(head);
+            string tag, seq, records;
+            hs >> tag >> seq >> records;
+            cout << "\n=== Update " << seq << " for " << filename << " (" << records
+                 << " records) ===\n";
+            while (getline(block, line)) {
+                size_t sep = line.rfind(": +");
+                if (sep == string::npos) continue;
+                long long d = stoll(line.substr(sep + 3));
+                long long& total = totals[line.substr(0, sep)];
+                total += d;
+                cout << line.substr(0, sep) << ": " << total << " (+" << d << ")\n";
+            }
+        }
+    };
+
+    bool ok = shipNewLines();
+    while (ok && !stopFollowing) {
+        pollfd fds[2] = {{sock, POLLIN, 0}, {notifyFd, POLLIN, 0}};
+        int rc = poll(fds, notifyFd >= 0 ? 2 : 1, 1000);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents) {
+            ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                cerr << "[ERROR] Server closed the follow session\n";
+                ok = false;
+                break;
+            }
+            inbox.append(buffer, static_cast<size_t>(n));
+            printPushes();
+        }
+        bool rotated = false;
+        if (notifyFd >= 0 && fds[1].revents) {
+            // Drain the event queue; only "the file was replaced" needs special care
+            char events[4096] __attribute__((aligned(__alignof__(inotify_event))));
+            ssize_t len;
+            while ((len = read(notifyFd, events, sizeof(events))) > 0) {
+                for (char* p = events; p < events + len; ) {
+                    auto* ev = reinterpret_cast<inotify_event*>(p);
+                    if (ev->wd == watch &&
+                        (ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED))) {
+                        rotated = true;
+                    }
+                    p += sizeof(inotify_event) + ev->len;
+                }
+            }
+        }
+        // Also catch rotations inotify cannot see (e.g. no watch, or recreated later)
+        struct stat onDisk, current;
+        if (stat(path.c_str(), &onDisk) == 0 &&
+            (fd < 0 || (fstat(fd, &current) == 0 && onDisk.st_ino != current.st_ino))) {
+            rotated = true;
+        }
+        if (rotated) reopen();
+        ok = shipNewLines();
+    }
+
+    // Half-close and wait for the final totals
+    shutdown(sock, SHUT_WR);
+    ssize_t n;
+    while ((n = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+        inbox.append(buffer, static_cast<size_t>(n));
+    }
+    printPushes();
     close(sock);
+    if (fd >= 0) close(fd);
+    if (notifyFd >= 0) close(notifyFd);
+    return ok ? 0 : 1;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Load-test mode:
+    //   client_app --load [--server IP:PORT] [--concurrency N] [--duration SEC]
+    //              [--rate REQ_PER_SEC] [--mix FORMAT:TYPE:RECORDS[:WEIGHT],...]
+    //              [--seed N] [--json FILE|-]
+    if (argc > 1 && string(argv[1]) == "--load") {
+        LoadConfig cfg;
+        string server = "127.0.0.1:8080", mix = "txt:LOG_LEVEL:10000";
+        bool valid = true;
+        for (int i = 2; i < argc && valid; ++i) {
+            string opt = argv[i];
+            if (i + 1 >= argc)                valid = false;
+            else if (opt == "--server")       server = argv[++i];
+            else if (opt == "--concurrency")  cfg.concurrency = max(1, stoi(argv[++i]));
+            else if (opt == "--duration")     cfg.durationSec = max(0.1, stod(argv[++i]));
+            else if (opt == "--rate")         cfg.rate = max(0.0, stod(argv[++i]));
+            else if (opt == "--mix")          mix = argv[++i];
+            else if (opt == "--seed")         cfg.seed = stoull(argv[++i]);
+            else if (opt == "--json")         cfg.jsonPath = argv[++i];
+            else                              valid = false;
+        }
+        size_t colon = server.rfind(':');
+        if (!valid || colon == string::npos) {
+            cerr << "Usage: " << argv[0] << " --load [--server IP:PORT] [--concurrency N]"
+                 << " [--duration SEC] [--rate REQ_PER_SEC]"
+                 << " [--mix FORMAT:TYPE:RECORDS[:WEIGHT],...] [--seed N] [--json FILE|-]\n";
+            return 1;
+        }
+        cfg.serverIp   = server.substr(0, colon);
+        cfg.serverPort = stoi(server.substr(colon + 1));
+        string err;
+        if (!parseLoadMix(mix, cfg.seed, cfg.mix, err)) {
+            cerr << "[ERROR] Invalid --mix: " << err << "\n";
+            return 1;
+        }
+        return runLoadTest(cfg);
+    }
+
+    // Non-interactive follow mode:
+    //   client_app --follow FILE [--server IP:PORT] [--type USER|IP|LOG_LEVEL]
+    //              [--interval-ms N] [--batch N] [--from-start]
+    if (argc > 1) {
+        string followPath, server = "127.0.0.1:8080", type = "LOG_LEVEL";
+        int intervalMs = 1000;
+        uint64_t batch = 10000;
+        bool fromStart = false;
+        for (int i = 1; i < argc; ++i) {
+            string opt = argv[i];
+            if (opt == "--follow" && i + 1 < argc)            followPath = argv[++i];
+            else if (opt == "--server" && i + 1 < argc)       server = argv[++i];
+            else if (opt == "--type" && i + 1 < argc)         type = argv[++i];
+            else if (opt == "--interval-ms" && i + 1 < argc)  intervalMs = stoi(argv[++i]);
+            else if (opt == "--batch" && i + 1 < argc)        batch = stoull(argv[++i]);
+            else if (opt == "--from-start")                   fromStart = true;
+            else {
+                followPath.clear();
+                break;
+            }
+        }
+        size_t colon = server.rfind(':');
+        if (followPath.empty() || colon == string::npos) {
+            cerr << "Usage: " << argv[0] << " --follow FILE [--server IP:PORT]"
+                 << " [--type USER|IP|LOG_LEVEL] [--interval-ms N] [--batch N] [--from-start]\n";
+            return 1;
+        }
+        return followFile(server.substr(0, colon), stoi(server.substr(colon + 1)),
+                          followPath, type, intervalMs, batch, fromStart);
+    }
+
     string serverIp;
     int         serverPort;
+    string mode;        // ANALYZE | INGEST | QUERY | INCREMENTAL
     string analysis;    // USER | IP | LOG_LEVEL
     string fromDate;    // YYYY-MM-DD
     string toDate;      // YYYY-MM-DD
@@ -87,31 +497,69 @@ int main() {
     getline(cin, portStr);
     serverPort = stoi(portStr);
 
-    cout << "Analysis type (USER, IP, or LOG_LEVEL): ";
-    getline(cin, analysis);
+    cout << "Mode (ANALYZE, INGEST, QUERY, or INCREMENTAL) [leave blank for ANALYZE]: ";
+    getline(cin, mode);
+    if (mode.empty()) mode = "ANALYZE";
+    if (mode != "ANALYZE" && mode != "INGEST" && mode != "QUERY" && mode != "INCREMENTAL") {
+        cerr << "[ERROR] Unknown mode: " << mode << "\n";
+        return 1;
+    }
+
+    // Ingest only uploads; analysis options are given later with QUERY
+    if (mode != "INGEST") {
+        cout << "Analysis type (USER, IP, or LOG_LEVEL): ";
+        getline(cin, analysis);
 
-    cout << "From date (YYYY-MM-DD) [leave blank for none]: ";
-    getline(cin, fromDate);
+        cout << "From date (YYYY-MM-DD) [leave blank for none]: ";
+        getline(cin, fromDate);
 
-    // Validate fromDate format
-    if (!fromDate.empty()) {
-        regex dateRegex(R"(^\d{4}-\d{2}-\d{2}$)");
-        if (!regex_match(fromDate, dateRegex)) {
-            cerr << "[ERROR] Invalid From date format. Expected YYYY-MM-DD\n";
-            return 1;
+        // Validate fromDate format
+        if (!fromDate.empty()) {
+            regex dateRegex(R"(^\d{4}-\d{2}-\d{2}$)");
+            if (!regex_match(fromDate, dateRegex)) {
+                cerr << "[ERROR] Invalid From date format. Expected YYYY-MM-DD\n";
+                return 1;
+            }
         }
-    }
 
-    cout << "To date (YYYY-MM-DD) [leave blank for none]: ";
-    getline(cin, toDate);
+        cout << "To date (YYYY-MM-DD) [leave blank for none]: ";
+        getline(cin, toDate);
+
+        // Validate toDate format
+        if (!toDate.empty()) {
+            regex dateRegex(R"(^\d{4}-\d{2}-\d{2}$)");
+            if (!regex_match(toDate, dateRegex)) {
+                cerr << "[ERROR] Invalid To date format. Expected YYYY-MM-DD\n";
+                return 1;
+            }
+        }
+    }
 
-    // Validate toDate format
-    if (!toDate.empty()) {
-        regex dateRegex(R"(^\d{4}-\d{2}-\d{2}$)");
-        if (!regex_match(toDate, dateRegex)) {
-            cerr << "[ERROR] Invalid To date format. Expected YYYY-MM-DD\n";
+    // Query stored datasets by id instead of uploading files
+    if (mode == "QUERY") {
+        cout << "Dataset ids (comma-separated, e.g. ds-1,ds-2): ";
+        string ids;
+        getline(cin, ids);
+        istringstream idStream(ids);
+        string id;
+        size_t idCount = 0;
+        while (getline(idStream, id, ',')) {
+            if (id.empty()) continue;
+            ++idCount;
+            ostringstream msg;
+            msg << "CMD:QUERY\n";
+            msg << "DATASET:" << id << "\n";
+            msg << "TYPE:" << analysis << "\n";
+            if (!fromDate.empty()) msg << "FROM:" << fromDate << "\n";
+            if (!toDate.empty())   msg << "TO:"   << toDate   << "\n";
+            msg << "\n";
+            sendAndReceive(serverIp, serverPort, msg.str(), id);
+        }
+        if (idCount == 0) {
+            cerr << "[ERROR] No dataset ids given\n";
             return 1;
         }
+        return 0;
     }
 
     cout << "Log folder path: ";
@@ -122,13 +570,30 @@ int main() {
         cerr << "[ERROR] Log folder does not exist: " << dirPath << "\n";
         return 1;
     }
+    // Incremental mode: only appended TXT lines are sent; offsets persist in the folder
+    if (mode == "INCREMENTAL") {
+        auto state = loadIncrementalState(dirPath);
+        size_t txtCount = 0;
+        for (auto& entry : fs::directory_iterator(dirPath)) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".txt") continue;
+            ++txtCount;
+            sendIncremental(serverIp, serverPort, entry.path(), analysis, fromDate, toDate, state);
+        }
+        saveIncrementalState(dirPath, state);
+        if (txtCount == 0) {
+            cerr << "[ERROR] No .txt log files found in folder: " << dirPath << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
     // Iterate over log files in directory
     size_t fileCount = 0;
     for (auto& entry : fs::directory_iterator(dirPath)) {
         if (!entry.is_regular_file()) continue;
         string path = entry.path().string();
         string ext  = entry.path().extension().string();
-        if (ext == ".json" || ext == ".xml" || ext == ".txt") {
+        if (ext == ".json" || ext == ".xml" || ext == ".txt" || ext == ".bin") {
             ++fileCount;
             // Read file content
             string fileContent;
@@ -139,9 +604,13 @@ int main() {
 
             // Build payload header + body
             ostringstream msg;
-            msg << "TYPE:" << analysis << "\n";
-            if (!fromDate.empty()) msg << "FROM:" << fromDate << "\n";
-            if (!toDate.empty())   msg << "TO:"   << toDate   << "\n";
+            if (mode == "INGEST") {
+                msg << "CMD:INGEST\n";
+            } else {
+                msg << "TYPE:" << analysis << "\n";
+                if (!fromDate.empty()) msg << "FROM:" << fromDate << "\n";
+                if (!toDate.empty())   msg << "TO:"   << toDate   << "\n";
+            }
             msg << "\n";
             msg << fileContent;
 
@@ -150,7 +619,7 @@ int main() {
         }
     }
     if (fileCount == 0) {
-        cerr << "[ERROR] No log files (.json, .xml, .txt) found in folder: " << dirPath << "\n";
+        cerr << "[ERROR] No log files (.json, .xml, .txt, .bin) found in folder: " << dirPath << "\n";
         return 1;
     }
 
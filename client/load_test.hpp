@@ -0,0 +1,290 @@
+// File: client/load_test.hpp
+// Load-test mode: concurrent open- or closed-loop requests with latency percentiles.
+
+#ifndef LOAD_TEST_HPP
+#define LOAD_TEST_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../generator/log_generator.hpp"
+#include "../server/metrics/hdr_histogram.hpp"
+#include "../server/parser/lib/nlohmann/json.hpp"
+
+using namespace std;
+
+// One kind of request in the mix: a generated payload analysed with one TYPE
+struct LoadMixEntry {
+    string   label;        ///< As given, e.g. "txt:LOG_LEVEL:10000"
+    FileType format;
+    string   type;         ///< TYPE header value
+    uint64_t records;
+    double   weight;
+    string   payload;      ///< Header + body, built once
+};
+
+struct LoadConfig {
+    string   serverIp    = "127.0.0.1";
+    int      serverPort  = 8080;
+    unsigned concurrency = 8;
+    double   durationSec = 10;
+    double   rate        = 0;   ///< Requests/s for an open loop; 0 = closed loop
+    uint64_t seed        = 1;
+    string   jsonPath;          ///< Write results as JSON here ("-" = stdout)
+    vector<LoadMixEntry> mix;
+};
+
+/**
+ * Parses "txt:LOG_LEVEL:10000:3,json:USER:2000" -- FORMAT:TYPE:RECORDS[:WEIGHT]
+ * with FORMAT json|txt|xml -- and generates each entry's payload.
+ * @return false (with err set) on a malformed entry.
+ */
+inline bool parseLoadMix(const string& spec, uint64_t seed, vector<LoadMixEntry>& out, string& err) {
+    out.clear();
+    istringstream is(spec);
+    string item;
+    while (getline(is, item, ',')) {
+        vector<string> parts;
+        istringstream ps(item);
+        string part;
+        while (getline(ps, part, ':')) parts.push_back(part);
+        if (parts.size() < 3 || parts.size() > 4) {
+            err = "mix entry '" + item + "' must be FORMAT:TYPE:RECORDS[:WEIGHT]";
+            return false;
+        }
+        LoadMixEntry e;
+        e.label = item;
+        if (parts[0] == "json")     e.format = FileType::JSON;
+        else if (parts[0] == "txt") e.format = FileType::TXT;
+        else if (parts[0] == "xml") e.format = FileType::XML;
+        else {
+            err = "unknown format '" + parts[0] + "' (json, txt or xml)";
+            return false;
+        }
+        e.type    = parts[1];
+        e.records = strtoull(parts[2].c_str(), nullptr, 10);
+        e.weight  = parts.size() == 4 ? atof(parts[3].c_str()) : 1.0;
+        if (e.weight <= 0) {
+            err = "weight must be positive in '" + item + "'";
+            return false;
+        }
+        GeneratorConfig gc;
+        gc.records = e.records;
+        gc.seed    = seed + out.size();
+        e.payload  = "TYPE:" + e.type + "\n\n" + LogGenerator(gc, e.format).renderAll();
+        out.push_back(move(e));
+    }
+    if (out.empty()) err = "empty mix";
+    return !out.empty();
+}
+
+/**
+ * Sends one request on a fresh connection and reads the reply to EOF.
+ * Quiet on purpose: failures are counted, not printed.
+ * @return false on a socket error, an empty reply or an [ERROR] reply.
+ */
+inline bool loadExchange(const sockaddr_in& addr, const string& payload,
+                         uint64_t& bytesIn) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return false;
+    bool ok = connect(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+    for (size_t sent = 0; ok && sent < payload.size();) {
+        ssize_t n = send(sock, payload.data() + sent, payload.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) ok = false;
+        else        sent += static_cast<size_t>(n);
+    }
+    if (ok) shutdown(sock, SHUT_WR);
+    char buf[8192];
+    char first[7] = {};
+    size_t got = 0;
+    ssize_t n;
+    while (ok && (n = recv(sock, buf, sizeof(buf), 0)) > 0) {
+        if (got < sizeof(first)) memcpy(first + got, buf, min(sizeof(first) - got, static_cast<size_t>(n)));
+        got += static_cast<size_t>(n);
+    }
+    close(sock);
+    bytesIn += got;
+    return ok && got > 0 && memcmp(first, "[ERROR]", 7) != 0;
+}
+
+/**
+ * Drives the server with cfg.concurrency connections for cfg.durationSec.
+ *
+ * Closed loop (rate 0): each worker sends its next request as soon as the
+ * previous reply is in; latency is the request's own round trip.
+ * Open loop (rate > 0): request k is due at start + k / rate whether or not
+ * earlier ones finished; latency is measured from that due time, so time
+ * spent waiting for a free connection is included rather than hidden
+ * (no coordinated omission).
+ *
+ * Each worker records into its own histograms (microseconds, ~0.2%
+ * precision); they are merged once at the end.
+ * @return process exit code.
+ */
+inline int runLoadTest(const LoadConfig& cfg) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(cfg.serverPort);
+    if (inet_pton(AF_INET, cfg.serverIp.c_str(), &addr.sin_addr) <= 0) {
+        cerr << "[ERROR] Invalid server IP: " << cfg.serverIp << "\n";
+        return 1;
+    }
+    double weightSum = 0;
+    for (const auto& e : cfg.mix) weightSum += e.weight;
+
+    struct WorkerStats {
+        vector<HdrHistogram> latency;  ///< Per mix entry
+        vector<uint64_t> ok, errors;
+        uint64_t bytesOut = 0, bytesIn = 0;
+    };
+    vector<WorkerStats> stats(cfg.concurrency);
+    for (auto& s : stats) {
+        s.latency.reserve(cfg.mix.size());
+        for (size_t i = 0; i < cfg.mix.size(); ++i) s.latency.emplace_back(10);
+        s.ok.assign(cfg.mix.size(), 0);
+        s.errors.assign(cfg.mix.size(), 0);
+    }
+
+    using Clock = chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end   = start + chrono::duration_cast<Clock::duration>(
+                                                chrono::duration<double>(cfg.durationSec));
+    atomic<uint64_t> nextRequest{0};
+
+    // Weighted pick of the mix entry for request k, independent of thread timing
+    auto pick = [&](uint64_t k) {
+        uint64_t h = (cfg.seed + k) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 32;
+        double u = static_cast<double>(h >> 11) * 0x1.0p-53 * weightSum;
+        size_t i = 0;
+        while (i + 1 < cfg.mix.size() && u >= cfg.mix[i].weight) u -= cfg.mix[i++].weight;
+        return i;
+    };
+
+    auto worker = [&](WorkerStats& s) {
+        while (true) {
+            uint64_t k = nextRequest.fetch_add(1, memory_order_relaxed);
+            Clock::time_point due = Clock::now();
+            if (cfg.rate > 0) {
+                due = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(k / cfg.rate));
+                if (due >= end) return;
+                this_thread::sleep_until(due);
+            } else if (due >= end) {
+                return;
+            }
+            size_t i = pick(k);
+            bool ok = loadExchange(addr, cfg.mix[i].payload, s.bytesIn);
+            auto micros = chrono::duration_cast<chrono::microseconds>(Clock::now() - due).count();
+            if (ok) {
+                ++s.ok[i];
+                s.bytesOut += cfg.mix[i].payload.size();
+                s.latency[i].record(static_cast<uint64_t>(micros));
+            } else {
+                ++s.errors[i];
+            }
+        }
+    };
+    vector<thread> pool;
+    for (auto& s : stats) pool.emplace_back(worker, ref(s));
+    for (auto& t : pool) t.join();
+    double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+    // Merge the per-worker results
+    HdrHistogram all(10);
+    vector<HdrHistogram> perEntry;
+    perEntry.reserve(cfg.mix.size());
+    vector<uint64_t> okCount(cfg.mix.size(), 0), errCount(cfg.mix.size(), 0);
+    uint64_t bytesOut = 0, bytesIn = 0;
+    for (size_t i = 0; i < cfg.mix.size(); ++i) perEntry.emplace_back(10);
+    for (const auto& s : stats) {
+        for (size_t i = 0; i < cfg.mix.size(); ++i) {
+            perEntry[i].merge(s.latency[i]);
+            all.merge(s.latency[i]);
+            okCount[i]  += s.ok[i];
+            errCount[i] += s.errors[i];
+        }
+        bytesOut += s.bytesOut;
+        bytesIn  += s.bytesIn;
+    }
+    uint64_t okTotal = 0, errTotal = 0;
+    for (size_t i = 0; i < cfg.mix.size(); ++i) {
+        okTotal  += okCount[i];
+        errTotal += errCount[i];
+    }
+
+    static const double pcts[] = {50, 90, 99, 99.9};
+    auto summary = [&](const string& label, const HdrHistogram& h, uint64_t ok, uint64_t errors) {
+        nlohmann::json j = {{"label", label}, {"ok", ok}, {"errors", errors},
+                            {"mean_ms", h.mean() / 1000.0}, {"max_ms", h.max() / 1000.0}};
+        for (double p : pcts) {
+            ostringstream key;
+            key << "p" << p << "_ms";
+            string k = key.str();
+            k.erase(remove(k.begin(), k.end(), '.'), k.end());  // p99.9 -> p999
+            j[k] = h.percentile(p) / 1000.0;
+        }
+        return j;
+    };
+
+    nlohmann::json result = {
+        {"server", cfg.serverIp + ":" + to_string(cfg.serverPort)},
+        {"concurrency", cfg.concurrency},
+        {"mode", cfg.rate > 0 ? "open" : "closed"},
+        {"target_rate", cfg.rate},
+        {"duration_s", elapsed},
+        {"requests_per_s", elapsed > 0 ? okTotal / elapsed : 0.0},
+        {"mb_sent_per_s", elapsed > 0 ? bytesOut / 1e6 / elapsed : 0.0},
+        {"bytes_sent", bytesOut},
+        {"bytes_received", bytesIn},
+        {"total", summary("ALL", all, okTotal, errTotal)},
+        {"mix", nlohmann::json::array()},
+    };
+    for (size_t i = 0; i < cfg.mix.size(); ++i) {
+        result["mix"].push_back(summary(cfg.mix[i].label, perEntry[i], okCount[i], errCount[i]));
+    }
+
+    // Human-readable table
+    printf("=== Load test: %u connections, %s loop, %.1f s ===\n", cfg.concurrency,
+           cfg.rate > 0 ? "open" : "closed", elapsed);
+    printf("%llu ok, %llu errors, %.1f req/s, %.1f MB/s sent\n",
+           static_cast<unsigned long long>(okTotal), static_cast<unsigned long long>(errTotal),
+           result["requests_per_s"].get<double>(), result["mb_sent_per_s"].get<double>());
+    printf("%-28s %8s %9s %9s %9s %9s %9s  (ms)\n", "MIX", "OK", "p50", "p90", "p99", "p99.9", "max");
+    auto row = [](const nlohmann::json& j) {
+        printf("%-28s %8llu %9.2f %9.2f %9.2f %9.2f %9.2f\n", j["label"].get<string>().c_str(),
+               j["ok"].get<unsigned long long>(), j["p50_ms"].get<double>(), j["p90_ms"].get<double>(),
+               j["p99_ms"].get<double>(), j["p999_ms"].get<double>(), j["max_ms"].get<double>());
+    };
+    for (const auto& j : result["mix"]) row(j);
+    row(result["total"]);
+
+    if (!cfg.jsonPath.empty()) {
+        if (cfg.jsonPath == "-") {
+            cout << result.dump(2) << "\n";
+        } else {
+            ofstream ofs(cfg.jsonPath);
+            ofs << result.dump(2) << "\n";
+            if (!ofs) {
+                cerr << "[ERROR] Cannot write " << cfg.jsonPath << "\n";
+                return 1;
+            }
+        }
+    }
+    return errTotal == 0 ? 0 : 2;
+}
+
+#endif // LOAD_TEST_HPP
@@ -0,0 +1,95 @@
+// File: converter/converter.cpp
+// Converts JSON / TXT / XML log files into the columnar PLOGBIN format.
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "../server/parser/log_parser.hpp"
+#include "../server/parser/json_parser.hpp"
+#include "../server/parser/txt_parser.hpp"
+#include "../server/parser/xml_parser.hpp"
+#include "../server/parser/bin_format.hpp"
+
+using namespace std;
+namespace fs = filesystem;
+
+// Read entire file into a string
+bool readFile(const string& path, string& out) {
+    ifstream ifs(path, ios::in | ios::binary);
+    if (!ifs.is_open()) return false;
+    ostringstream oss;
+    oss << ifs.rdbuf();
+    out = oss.str();
+    return true;
+}
+
+void usage(const char* prog) {
+    cerr << "Usage: " << prog << " <input.json|.txt|.xml> <output.bin>"
+         << " [--no-message] [--block-records N]\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    string inPath  = argv[1];
+    string outPath = argv[2];
+    bool withMessages = true;
+    uint32_t blockRecords = BIN_DEFAULT_BLOCK_RECORDS;
+    for (int i = 3; i < argc; ++i) {
+        string opt = argv[i];
+        if (opt == "--no-message") {
+            withMessages = false;
+        } else if (opt == "--block-records" && i + 1 < argc) {
+            blockRecords = static_cast<uint32_t>(stoul(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    string content;
+    if (!readFile(inPath, content)) {
+        cerr << "[ERROR] Cannot open log file: " << inPath << "\n";
+        return 1;
+    }
+
+    // Select parser by extension, as the client does
+    string ext = fs::path(inPath).extension().string();
+    unique_ptr<LogParser> parser;
+    if (ext == ".json")     parser.reset(new JSONParser(content));
+    else if (ext == ".txt") parser.reset(new TXTParser(content));
+    else if (ext == ".xml") parser.reset(new XMLParser(content));
+    else {
+        cerr << "[ERROR] Unsupported input extension: " << ext << "\n";
+        return 1;
+    }
+    content.clear();
+    content.shrink_to_fit();
+
+    auto t0 = chrono::steady_clock::now();
+    BinWriter writer(withMessages, blockRecords);
+    try {
+        parser->forEachRecord([&](const LogRecord& rec) { writer.add(rec); });
+    } catch (const exception& e) {
+        cerr << "[ERROR] Conversion failed: " << e.what() << "\n";
+        return 1;
+    }
+    string image = writer.finish();
+
+    ofstream ofs(outPath, ios::out | ios::binary | ios::trunc);
+    if (!ofs.write(image.data(), static_cast<streamsize>(image.size()))) {
+        cerr << "[ERROR] Cannot write output file: " << outPath << "\n";
+        return 1;
+    }
+    auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - t0).count();
+    cout << "[INFO] Wrote " << writer.recordCount() << " records ("
+         << image.size() << " bytes) to " << outPath << " in " << ms << " ms\n";
+    return 0;
+}
@@ -0,0 +1,318 @@
+// File: generator/log_generator.hpp
+// LogGenerator: Deterministic synthetic logs in the JSON, TXT and XML layouts.
+
+#ifndef LOG_GENERATOR_HPP
+#define LOG_GENERATOR_HPP
+
+#include "../server/parser/date_filter.hpp"
+#include "../server/parser/log_record.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+struct GeneratorConfig {
+    uint64_t records     = 100000;
+    int64_t  start       = 1725148800;      ///< First timestamp (2024-09-01 00:00:00 UTC)
+    int64_t  spanSeconds = 30 * 86400;      ///< Timestamps are spread evenly over this span
+    vector<pair<string, double>> levels = {
+        {"INFO", 40}, {"DEBUG", 25}, {"WARN", 20}, {"ERROR", 10}, {"CRITICAL", 5}};
+    uint64_t users   = 5000;                ///< Distinct user ids
+    uint64_t ips     = 5000;                ///< Distinct IP addresses
+    double   zipf    = 1.0;                 ///< Skew of users/IPs; 0 = uniform
+    size_t   msgMin  = 16;                  ///< Message length range in bytes
+    size_t   msgMax  = 64;
+    uint64_t seed    = 1;
+
+    /**
+     * Parses "INFO=40,DEBUG=25,ERROR=5" (weights need not sum to 100).
+     * @return false on a malformed item or if no weight is positive.
+     */
+    static bool parseLevels(const string& spec, vector<pair<string, double>>& out) {
+        out.clear();
+        istringstream is(spec);
+        string item;
+        double total = 0;
+        while (getline(is, item, ',')) {
+            size_t eq = item.find('=');
+            if (eq == 0 || eq == string::npos) return false;
+            double w = atof(item.c_str() + eq + 1);
+            if (w < 0) return false;
+            out.push_back({item.substr(0, eq), w});
+            total += w;
+        }
+        return total > 0;
+    }
+};
+
+/**
+ * Zipf-distributed ranks 1..n with P(k) proportional to k^-s, by
+ * rejection-inversion (Hörmann & Derflinger): O(1) memory and expected O(1)
+ * time per sample, whatever n is.
+ */
+class ZipfSampler {
+public:
+    ZipfSampler(uint64_t n, double s)
+        : n(max<uint64_t>(n, 1)), exponent(s) {
+        if (exponent <= 0) return;
+        hIntegralX1 = hIntegral(1.5) - 1.0;
+        hIntegralN  = hIntegral(static_cast<double>(this->n) + 0.5);
+        squeeze     = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+    }
+
+    // Rank in [1, n]; u01() must return uniform doubles in [0, 1)
+    template <typename Uniform>
+    uint64_t sample(Uniform&& u01) const {
+        if (exponent <= 0) return 1 + static_cast<uint64_t>(u01() * static_cast<double>(n)) % n;
+        while (true) {
+            double u = hIntegralN + u01() * (hIntegralX1 - hIntegralN);
+            double x = hIntegralInverse(u);
+            double k = floor(x + 0.5);
+            if (k < 1) k = 1;
+            else if (k > static_cast<double>(n)) k = static_cast<double>(n);
+            if (k - x <= squeeze || u >= hIntegral(k + 0.5) - h(k)) return static_cast<uint64_t>(k);
+        }
+    }
+
+private:
+    double h(double x) const { return exp(-exponent * log(x)); }
+
+    double hIntegral(double x) const {
+        double logX = log(x);
+        return helper2((1.0 - exponent) * logX) * logX;
+    }
+
+    double hIntegralInverse(double x) const {
+        double t = max(-1.0, x * (1.0 - exponent));
+        return exp(helper1(t) * x);
+    }
+
+    // log1p(x)/x and expm1(x)/x, with series near 0
+    static double helper1(double x) {
+        return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+    static double helper2(double x) {
+        return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+    }
+
+    uint64_t n;
+    double exponent;
+    double hIntegralX1 = 0, hIntegralN = 0, squeeze = 0;
+};
+
+/**
+ * Renders records in chunks of CHUNK_RECORDS. Each chunk seeds its own
+ * random stream from (seed, chunk index), so chunks can be rendered on any
+ * thread in any order and the concatenated output is byte-identical for a
+ * given config. Timestamps increase evenly across the span.
+ */
+class LogGenerator {
+public:
+    static constexpr uint64_t CHUNK_RECORDS = 16384;
+
+    LogGenerator(const GeneratorConfig& config, FileType format)
+        : cfg(config), fmt(format),
+          userDist(config.users, config.zipf), ipDist(config.ips, config.zipf) {
+        double total = 0;
+        for (const auto& lv : cfg.levels) total += lv.second;
+        double acc = 0;
+        for (const auto& lv : cfg.levels) {
+            acc += lv.second / total;
+            levelCdf.push_back(acc);
+        }
+        if (cfg.msgMax < cfg.msgMin) cfg.msgMax = cfg.msgMin;
+    }
+
+    uint64_t chunkCount() const { return (cfg.records + CHUNK_RECORDS - 1) / CHUNK_RECORDS; }
+
+    string header() const {
+        switch (fmt) {
+            case FileType::JSON: return "[\n";
+            case FileType::XML:  return "<logs>\n";
+            default:             return "";
+        }
+    }
+
+    string footer() const {
+        switch (fmt) {
+            case FileType::JSON: return cfg.records ? "\n]\n" : "]\n";
+            case FileType::XML:  return "</logs>\n";
+            default:             return "";
+        }
+    }
+
+    // Appends the records of one chunk to out
+    void renderChunk(uint64_t chunk, string& out) const {
+        uint64_t first = chunk * CHUNK_RECORDS;
+        uint64_t last  = min(cfg.records, first + CHUNK_RECORDS);
+        uint64_t state = mix(cfg.seed ^ mix(chunk + 1));
+        auto next = [&]() { return state = mix(state); };
+        auto u01  = [&]() { return static_cast<double>(next() >> 11) * 0x1.0p-53; };
+
+        out.reserve(out.size() + (last - first) * (cfg.msgMax + 200));
+        int64_t cachedDay = INT64_MIN;
+        char date[11] = {};
+        string message;
+        for (uint64_t i = first; i < last; ++i) {
+            int64_t t = cfg.start + static_cast<int64_t>(
+                static_cast<unsigned __int128>(i) * static_cast<uint64_t>(max<int64_t>(cfg.spanSeconds, 0)) /
+                max<uint64_t>(cfg.records, 1));
+            int64_t day = floorDiv(t, 86400);
+            if (day != cachedDay) {
+                formatDate(day, date);
+                cachedDay = day;
+            }
+            int64_t secs = t - day * 86400;
+
+            double pick = u01();
+            size_t li = 0;
+            while (li + 1 < levelCdf.size() && pick >= levelCdf[li]) ++li;
+            const string& level = cfg.levels[li].first;
+
+            uint64_t userId = 999 + userDist.sample(u01);
+            uint32_t ip     = scrambleIp(ipDist.sample(u01));
+            size_t   msgLen = cfg.msgMin + next() % (cfg.msgMax - cfg.msgMin + 1);
+            makeMessage(msgLen, next, message);
+
+            char ts[20];
+            memcpy(ts, date, 10);
+            ts[10] = ' ';
+            put2(ts + 11, secs / 3600);
+            ts[13] = ':';
+            put2(ts + 14, secs / 60 % 60);
+            ts[16] = ':';
+            put2(ts + 17, secs % 60);
+            string_view tsv(ts, 19);
+            string ipText = formatIPv4(ip);
+
+            switch (fmt) {
+                case FileType::JSON:
+                    if (i > 0) out += ",\n";
+                    out += "  {\n    \"timestamp\": \"";
+                    out += tsv;
+                    out += "\",\n    \"log_level\": \"";
+                    out += level;
+                    out += "\",\n    \"message\": \"";
+                    out += message;
+                    out += "\",\n    \"user_id\": ";
+                    appendNumber(out, userId);
+                    out += ",\n    \"ip_address\": \"";
+                    out += ipText;
+                    out += "\"\n  }";
+                    break;
+                case FileType::XML:
+                    out += "  <log>\n    <timestamp>";
+                    out += tsv;
+                    out += "</timestamp>\n    <log_level>";
+                    out += level;
+                    out += "</log_level>\n    <message>";
+                    out += message;
+                    out += "</message>\n    <user_id>";
+                    appendNumber(out, userId);
+                    out += "</user_id>\n    <ip_address>";
+                    out += ipText;
+                    out += "</ip_address>\n  </log>\n";
+                    break;
+                default:
+                    out += tsv;
+                    out += " | ";
+                    out += level;
+                    out += " | ";
+                    out += message;
+                    out += " | UserID: ";
+                    appendNumber(out, userId);
+                    out += " | IP: ";
+                    out += ipText;
+                    out += '\n';
+                    break;
+            }
+        }
+    }
+
+    // The whole document in memory (for small outputs and the bench)
+    string renderAll() const {
+        string out = header();
+        for (uint64_t c = 0; c < chunkCount(); ++c) renderChunk(c, out);
+        return out + footer();
+    }
+
+private:
+    // SplitMix64 finaliser; also the per-chunk random stream
+    static uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    static int64_t floorDiv(int64_t a, int64_t b) { return a / b - ((a % b != 0) && ((a < 0) != (b < 0))); }
+
+    static void put2(char* p, int64_t v) {
+        p[0] = static_cast<char>('0' + v / 10);
+        p[1] = static_cast<char>('0' + v % 10);
+    }
+
+    static void appendNumber(string& out, uint64_t v) {
+        char buf[20];
+        auto res = to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, res.ptr);
+    }
+
+    // Days since 1970-01-01 -> "YYYY-MM-DD" (civil-from-days)
+    static void formatDate(int64_t days, char* out) {
+        days += 719468;
+        int64_t era = floorDiv(days, 146097);
+        int64_t doe = days - era * 146097;
+        int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        int64_t mp  = (5 * doy + 2) / 153;
+        int64_t d   = doy - (153 * mp + 2) / 5 + 1;
+        int64_t m   = mp < 10 ? mp + 3 : mp - 9;
+        int64_t y   = yoe + era * 400 + (m <= 2);
+        y = ((y % 10000) + 10000) % 10000;
+        put2(out, y / 100);
+        put2(out + 2, y % 100);
+        out[4] = '-';
+        put2(out + 5, m);
+        out[7] = '-';
+        put2(out + 8, d);
+    }
+
+    // Rank -> address: a bijection on 32 bits so distinct ranks stay distinct
+    static uint32_t scrambleIp(uint64_t rank) {
+        uint32_t x = static_cast<uint32_t>(rank) * 2654435761u;
+        return x ^ (x >> 16);
+    }
+
+    // Words up to len bytes (at least one word); safe in all three formats
+    template <typename Next>
+    static void makeMessage(size_t len, Next& next, string& out) {
+        static const char* words[] = {
+            "request", "served", "user", "login", "failed", "connection", "timeout", "refused",
+            "cache", "miss", "hit", "disk", "write", "read", "retry", "session", "expired",
+            "token", "invalid", "payment", "processed", "queue", "full", "service", "started",
+            "stopped", "upstream", "latency", "high", "config", "reloaded", "error"};
+        out.clear();
+        while (true) {
+            const char* w = words[next() % (sizeof(words) / sizeof(words[0]))];
+            size_t wl = strlen(w);
+            if (!out.empty() && out.size() + 1 + wl > len) break;
+            if (!out.empty()) out += ' ';
+            out += w;
+            if (out.size() >= len) break;
+        }
+    }
+
+    GeneratorConfig cfg;
+    FileType fmt;
+    ZipfSampler userDist, ipDist;
+    vector<double> levelCdf;
+};
+
+#endif // LOG_GENERATOR_HPP
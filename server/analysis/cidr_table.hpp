@@ -0,0 +1,102 @@
+// File: server/analysis/cidr_table.hpp
+// CidrTable: Longest-prefix match of IPv4 addresses against named CIDR blocks.
+
+#ifndef CIDR_TABLE_HPP
+#define CIDR_TABLE_HPP
+
+#include "../parser/log_record.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * CIDR blocks are either disjoint or nested, so the address space splits into
+ * disjoint ranges, each owned by the most specific block covering it. build()
+ * computes those ranges once with a sweep over the blocks sorted by start;
+ * lookup() is then a binary search in a flat sorted array, O(log n) per
+ * address with no pointer chasing.
+ */
+class CidrTable {
+public:
+    static constexpr uint32_t NO_MATCH = UINT32_MAX;
+
+    /**
+     * Adds a block; call build() after the last one.
+     * @param name Label reported for addresses in the block; blocks may share one.
+     * @param cidr "10.0.0.0/8" or a bare address (/32).
+     * @return false if cidr cannot be parsed.
+     */
+    bool add(const string& name, const string& cidr) {
+        uint32_t network;
+        int bits;
+        if (!parseCIDR(cidr, network, bits)) return false;
+        uint32_t last  = network | ~prefixMask(bits);
+        uint32_t label = static_cast<uint32_t>(find(names.begin(), names.end(), name) - names.begin());
+        if (label == names.size()) names.push_back(name);
+        blocks.push_back({network, last, bits, label});
+        return true;
+    }
+
+    // Flattens the blocks into disjoint, most-specific ranges
+    void build() {
+        // Larger (shorter-prefix) blocks first among those starting together,
+        // so nested blocks end up above their parent on the stack
+        sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) {
+            return a.first != b.first ? a.first < b.first : a.bits < b.bits;
+        });
+        ranges.clear();
+        vector<const Block*> open;
+        uint64_t cursor = 0;  // first address not yet assigned
+        auto emitUpTo = [&](uint64_t last) {
+            if (!open.empty() && cursor <= last) {
+                ranges.push_back({static_cast<uint32_t>(cursor), static_cast<uint32_t>(last),
+                                  open.back()->label});
+            }
+            if (cursor <= last) cursor = last + 1;
+        };
+        for (const Block& b : blocks) {
+            while (!open.empty() && open.back()->last < b.first) {
+                emitUpTo(open.back()->last);
+                open.pop_back();
+            }
+            if (b.first > 0) emitUpTo(uint64_t(b.first) - 1);
+            open.push_back(&b);
+        }
+        while (!open.empty()) {
+            emitUpTo(open.back()->last);
+            open.pop_back();
+        }
+    }
+
+    // Label index of the most specific block holding ip, or NO_MATCH
+    uint32_t lookup(uint32_t ip) const {
+        auto it = upper_bound(ranges.begin(), ranges.end(), ip,
+                              [](uint32_t v, const Range& r) { return v < r.first; });
+        if (it == ranges.begin()) return NO_MATCH;
+        --it;
+        return ip <= it->last ? it->label : NO_MATCH;
+    }
+
+    const string& name(uint32_t label) const { return names[label]; }
+    size_t size() const { return names.size(); }
+
+private:
+    struct Block {
+        uint32_t first, last;
+        int      bits;
+        uint32_t label;
+    };
+    struct Range {
+        uint32_t first, last;
+        uint32_t label;
+    };
+
+    vector<Block>  blocks;  ///< As added (sorted by build)
+    vector<Range>  ranges;  ///< Disjoint, ascending
+    vector<string> names;   ///< Label index -> name
+};
+
+#endif // CIDR_TABLE_HPP
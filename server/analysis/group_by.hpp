@@ -0,0 +1,222 @@
+// File: server/analysis/group_by.hpp
+// GroupBy: Record counts per ordered tuple of dimensions (e.g. USER x LOG_LEVEL).
+
+#ifndef GROUP_BY_HPP
+#define GROUP_BY_HPP
+
+#include "../parser/log_record.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+enum class GroupDim { USER, IP, LOG_LEVEL };
+
+/**
+ * Each dimension is reduced to a fixed-width integer: user ids and IPv4
+ * addresses are 32 bits, levels are interned to an 8-bit index. When the
+ * tuple fits in 64 bits (any pair, or a single dimension) the fields are
+ * packed into one uint64_t key, first dimension in the high bits; only
+ * USER x IP x LOG_LEVEL needs the wider fallback, a 9-byte binary string
+ * key that still stays inside the small-string buffer.
+ */
+class GroupBy {
+public:
+    static constexpr size_t MAX_DIMS = 3;
+
+    /**
+     * Parses "USER,LOG_LEVEL" style lists; each dimension may appear once.
+     * @return false on an unknown, repeated or missing dimension.
+     */
+    static bool parseDims(const string& spec, vector<GroupDim>& out) {
+        out.clear();
+        istringstream is(spec);
+        string item;
+        while (getline(is, item, ',')) {
+            size_t s = item.find_first_not_of(" \t");
+            size_t e = item.find_last_not_of(" \t\r");
+            if (s == string::npos) continue;
+            item = item.substr(s, e - s + 1);
+            GroupDim d;
+            if (item == "USER")           d = GroupDim::USER;
+            else if (item == "IP")        d = GroupDim::IP;
+            else if (item == "LOG_LEVEL") d = GroupDim::LOG_LEVEL;
+            else return false;
+            if (find(out.begin(), out.end(), d) != out.end()) return false;
+            out.push_back(d);
+        }
+        return !out.empty() && out.size() <= MAX_DIMS;
+    }
+
+    explicit GroupBy(vector<GroupDim> dimensions)
+        : dims(move(dimensions)) {
+        unsigned bits = 0;
+        for (GroupDim d : dims) {
+            bits += bitsOf(d);
+            if (d == GroupDim::USER) needs |= LogRecord::USER;
+            if (d == GroupDim::IP)   needs |= LogRecord::IP;
+        }
+        packed = bits <= 64;
+    }
+
+    // Records whose user id or IP did not convert are left out of groups on that dimension
+    void add(const LogRecord& rec) {
+        if (!rec.has(needs)) return;
+        if (packed) {
+            uint64_t key = 0;
+            for (GroupDim d : dims) key = (key << bitsOf(d)) | value(d, rec);
+            ++packedCounts[key];
+        } else {
+            char buf[MAX_DIMS * 4];
+            size_t n = 0;
+            for (GroupDim d : dims) {
+                uint32_t v = value(d, rec);
+                size_t bytes = bitsOf(d) / 8;
+                memcpy(buf + n, &v, bytes);  // little-endian: low bytes first
+                n += bytes;
+            }
+            ++wideCounts[string(buf, n)];
+        }
+    }
+
+    /**
+     * Renders the groups sorted by tuple (numbers ascending, levels by name).
+     * Flat:   "2588,ERROR: 27", one line per tuple.
+     * Nested: one line per distinct prefix with its subtotal, children indented
+     *         by two spaces, e.g. "2588: 133" then "  ERROR: 27".
+     */
+    string format(bool nested) const {
+        vector<Row> rows = decodeRows();
+        ostringstream out;
+        if (rows.empty()) {
+            out << "[INFO] No entries matched your query.\n";
+            return out.str();
+        }
+        if (nested) {
+            renderNested(out, rows, 0, rows.size(), 0);
+        } else {
+            for (const auto& row : rows) {
+                for (size_t i = 0; i < dims.size(); ++i) {
+                    out << (i ? "," : "") << label(dims[i], row.vals[i]);
+                }
+                out << ": " << row.count << "\n";
+            }
+        }
+        return out.str();
+    }
+
+private:
+    struct Row {
+        array<uint32_t, MAX_DIMS> vals{};
+        array<uint32_t, MAX_DIMS> order{};  ///< Sort keys (level rank by name)
+        uint64_t count = 0;
+    };
+
+    static unsigned bitsOf(GroupDim d) { return d == GroupDim::LOG_LEVEL ? 8 : 32; }
+
+    uint32_t value(GroupDim d, const LogRecord& rec) {
+        switch (d) {
+            case GroupDim::USER: return rec.userId;
+            case GroupDim::IP:   return rec.ip;
+            case GroupDim::LOG_LEVEL:
+            default:             return levelId(rec.level);
+        }
+    }
+
+    // Interned index of a level; past 255 names the rest share "(other)"
+    uint32_t levelId(string_view level) {
+        for (size_t i = 0; i < levelNames.size(); ++i) {
+            if (levelNames[i] == level) return static_cast<uint32_t>(i);
+        }
+        if (levelNames.size() == 255) levelNames.emplace_back("(other)");
+        if (levelNames.size() == 256) return 255;
+        levelNames.emplace_back(level);
+        return static_cast<uint32_t>(levelNames.size() - 1);
+    }
+
+    string label(GroupDim d, uint32_t v) const {
+        switch (d) {
+            case GroupDim::USER: return to_string(v);
+            case GroupDim::IP:   return formatIPv4(v);
+            case GroupDim::LOG_LEVEL:
+            default:             return levelNames[v];
+        }
+    }
+
+    // Unpack every key into per-dimension values and sort by tuple
+    vector<Row> decodeRows() const {
+        vector<uint32_t> levelRank(levelNames.size());
+        {
+            vector<uint32_t> byName(levelNames.size());
+            for (uint32_t i = 0; i < byName.size(); ++i) byName[i] = i;
+            sort(byName.begin(), byName.end(),
+                 [&](uint32_t a, uint32_t b) { return levelNames[a] < levelNames[b]; });
+            for (uint32_t r = 0; r < byName.size(); ++r) levelRank[byName[r]] = r;
+        }
+        auto finish = [&](Row& row) {
+            for (size_t i = 0; i < dims.size(); ++i) {
+                row.order[i] = dims[i] == GroupDim::LOG_LEVEL ? levelRank[row.vals[i]] : row.vals[i];
+            }
+        };
+
+        vector<Row> rows;
+        rows.reserve(packed ? packedCounts.size() : wideCounts.size());
+        for (const auto& kv : packedCounts) {
+            Row row;
+            uint64_t key = kv.first;
+            for (size_t i = dims.size(); i-- > 0;) {
+                unsigned bits = bitsOf(dims[i]);
+                row.vals[i] = static_cast<uint32_t>(key & ((uint64_t(1) << bits) - 1));
+                key >>= bits;
+            }
+            row.count = kv.second;
+            finish(row);
+            rows.push_back(row);
+        }
+        for (const auto& kv : wideCounts) {
+            Row row;
+            size_t n = 0;
+            for (size_t i = 0; i < dims.size(); ++i) {
+                size_t bytes = bitsOf(dims[i]) / 8;
+                memcpy(&row.vals[i], kv.first.data() + n, bytes);
+                n += bytes;
+            }
+            row.count = kv.second;
+            finish(row);
+            rows.push_back(row);
+        }
+        sort(rows.begin(), rows.end(),
+             [](const Row& a, const Row& b) { return a.order < b.order; });
+        return rows;
+    }
+
+    // Rows [begin, end) share their first `depth` values
+    void renderNested(ostringstream& out, const vector<Row>& rows,
+                      size_t begin, size_t end, size_t depth) const {
+        const string indent(depth * 2, ' ');
+        while (begin < end) {
+            size_t run = begin;
+            uint64_t subtotal = 0;
+            while (run < end && rows[run].vals[depth] == rows[begin].vals[depth]) {
+                subtotal += rows[run++].count;
+            }
+            out << indent << label(dims[depth], rows[begin].vals[depth]) << ": " << subtotal << "\n";
+            if (depth + 1 < dims.size()) renderNested(out, rows, begin, run, depth + 1);
+            begin = run;
+        }
+    }
+
+    vector<GroupDim> dims;
+    bool packed = true;
+    uint8_t needs = 0;                               ///< LogRecord::Field bits the dimensions read
+    vector<string> levelNames;                       ///< Level index -> name
+    unordered_map<uint64_t, uint64_t> packedCounts;  ///< Packed tuple -> count
+    unordered_map<string, uint64_t>   wideCounts;    ///< Byte tuple -> count (> 64 bits)
+};
+
+#endif // GROUP_BY_HPP
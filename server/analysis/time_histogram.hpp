@@ -0,0 +1,156 @@
+// File: server/analysis/time_histogram.hpp
+// TimeHistogram: Record counts per fixed-width time bucket, optionally split by log level.
+
+#ifndef TIME_HISTOGRAM_HPP
+#define TIME_HISTOGRAM_HPP
+
+#include "../parser/log_record.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Buckets are aligned to multiples of the width since the epoch, so an HOUR
+ * histogram always starts on the hour. Counts are kept in dense arrays indexed
+ * by bucket number (one array for the totals, one per level when split), and
+ * every bucket between the first and last record is reported, including empty
+ * ones, so gaps in the traffic are visible.
+ */
+class TimeHistogram {
+public:
+    static constexpr size_t MAX_BUCKETS = 1u << 20;  ///< Span cap; records beyond it are dropped
+
+    /**
+     * @param widthSeconds Bucket width (60, 3600, 86400, ...).
+     * @param byLevel      Also count each bucket per log level.
+     */
+    TimeHistogram(int64_t widthSeconds, bool byLevel)
+        : width(widthSeconds > 0 ? widthSeconds : 1), splitLevels(byLevel) {}
+
+    // Width in seconds for "MINUTE", "HOUR" or "DAY"; 0 for anything else
+    static int64_t widthFor(const string& name) {
+        if (name == "MINUTE") return 60;
+        if (name == "HOUR")   return 3600;
+        if (name == "DAY")    return 86400;
+        return 0;
+    }
+
+    void add(const LogRecord& rec) {
+        if (rec.has(LogRecord::TIMESTAMP)) add(rec.timestamp, rec.level);
+    }
+
+    void add(int64_t timestamp, string_view level) {
+        int64_t bucket = timestamp / width;
+        if (timestamp % width < 0) --bucket;  // floor for pre-1970 stamps
+        if (!reserveBucket(bucket)) {
+            ++dropped;
+            return;
+        }
+        size_t slot = static_cast<size_t>(bucket - base);
+        ++totals[slot];
+        if (splitLevels) ++levelCounts[levelIndex(level)][slot];
+    }
+
+    // Records that fell outside the MAX_BUCKETS span and were not counted
+    uint64_t droppedCount() const { return dropped; }
+
+    /**
+     * Renders the histogram as a table, one line per bucket:
+     *   TIME | TOTAL [| LEVEL ...]
+     *   2024-09-01 10:00:00 | 812 [| 160 | ...]
+     * Level columns are in name order.
+     */
+    string format() const {
+        ostringstream out;
+        if (!any) {
+            out << "[INFO] No entries matched your query.\n";
+            return out.str();
+        }
+        vector<size_t> order(levelNames.size());
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(),
+             [&](size_t a, size_t b) { return levelNames[a] < levelNames[b]; });
+
+        out << "TIME | TOTAL";
+        for (size_t l : order) out << " | " << levelNames[l];
+        out << "\n";
+        for (int64_t b = lo; b <= hi; ++b) {
+            size_t slot = static_cast<size_t>(b - base);
+            out << formatTimestamp(b * width) << " | " << totals[slot];
+            for (size_t l : order) out << " | " << levelCounts[l][slot];
+            out << "\n";
+        }
+        if (dropped > 0) {
+            out << "[WARN] " << dropped << " record(s) outside the " << MAX_BUCKETS
+                << "-bucket span were not counted\n";
+        }
+        return out.str();
+    }
+
+private:
+    /**
+     * Makes bucket addressable, growing the dense arrays at either end.
+     * Growth at the front doubles the allocation so reverse-ordered input stays
+     * linear overall; [lo, hi] tracks the buckets actually seen.
+     */
+    bool reserveBucket(int64_t bucket) {
+        if (!any) {
+            any  = true;
+            base = lo = hi = bucket;
+            resizeAll(1, 0);
+            return true;
+        }
+        int64_t newLo = min(lo, bucket), newHi = max(hi, bucket);
+        if (static_cast<uint64_t>(newHi - newLo) >= MAX_BUCKETS) return false;
+
+        if (bucket < base) {
+            int64_t grow = max<int64_t>(base - bucket, static_cast<int64_t>(totals.size()));
+            grow = min<int64_t>(grow, base - (hi - static_cast<int64_t>(MAX_BUCKETS) + 1));
+            resizeAll(totals.size() + static_cast<size_t>(grow), static_cast<size_t>(grow));
+            base -= grow;
+        } else if (static_cast<size_t>(bucket - base) >= totals.size()) {
+            resizeAll(static_cast<size_t>(bucket - base) + 1, 0);
+        }
+        lo = newLo;
+        hi = newHi;
+        return true;
+    }
+
+    // Resize every dense array to n slots, inserting `front` zero slots at the start
+    void resizeAll(size_t n, size_t front) {
+        auto grow = [&](vector<uint64_t>& v) {
+            if (front > 0) v.insert(v.begin(), front, 0);
+            v.resize(n, 0);
+        };
+        grow(totals);
+        for (auto& counts : levelCounts) grow(counts);
+    }
+
+    // Column of a level name, adding a new dense array on first sight
+    size_t levelIndex(string_view level) {
+        for (size_t i = 0; i < levelNames.size(); ++i) {
+            if (levelNames[i] == level) return i;
+        }
+        levelNames.emplace_back(level);
+        levelCounts.emplace_back(totals.size(), 0);
+        return levelNames.size() - 1;
+    }
+
+    int64_t width;
+    bool    splitLevels;
+    bool    any  = false;
+    int64_t base = 0;          ///< Bucket number of slot 0
+    int64_t lo   = 0, hi = 0;  ///< First and last bucket holding a record
+    uint64_t dropped = 0;
+
+    vector<uint64_t>         totals;       ///< Records per slot
+    vector<string>           levelNames;   ///< Level of each levelCounts column
+    vector<vector<uint64_t>> levelCounts;  ///< [level][slot] when split by level
+};
+
+#endif // TIME_HISTOGRAM_HPP
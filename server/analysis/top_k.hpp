@@ -0,0 +1,126 @@
+// File: server/analysis/top_k.hpp
+// Top-K heavy hitters: a bounded-memory Space-Saving sketch and an exact partial sort.
+
+#ifndef TOP_K_HPP
+#define TOP_K_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Space-Saving (Metwally et al.) over a fixed number of counters.
+ * Every key whose true frequency exceeds total/capacity is guaranteed to be
+ * held, and each held count overestimates the true one by at most its
+ * `error`, i.e. true count lies in [count - error, count].
+ *
+ * Counters live in a min-heap ordered by count plus a key -> heap slot map,
+ * so an update costs O(log capacity) and memory is O(capacity) no matter how
+ * many distinct keys the stream contains.
+ */
+template <typename Key, typename Hash = hash<Key>>
+class SpaceSaving {
+public:
+    struct Entry {
+        Key      key{};
+        uint64_t count = 0;  ///< Upper bound of the true frequency
+        uint64_t error = 0;  ///< Maximum overestimation of count
+    };
+
+    explicit SpaceSaving(size_t capacity)
+        : cap(max<size_t>(1, capacity)) {
+        heap.reserve(cap);
+        slot.reserve(cap);
+    }
+
+    void add(const Key& key) {
+        ++n;
+        auto it = slot.find(key);
+        if (it != slot.end()) {
+            ++heap[it->second].count;
+            siftDown(it->second);
+        } else if (heap.size() < cap) {
+            heap.push_back({key, 1, 0});
+            slot[key] = heap.size() - 1;
+            siftUp(heap.size() - 1);
+        } else {
+            // Replace the smallest counter; its count becomes the newcomer's error
+            slot.erase(heap[0].key);
+            uint64_t floor = heap[0].count;
+            heap[0] = {key, floor + 1, floor};
+            slot[key] = 0;
+            siftDown(0);
+        }
+    }
+
+    /**
+     * The k largest counters, highest count first.
+     * @param k Number of entries wanted (at most capacity()).
+     */
+    vector<Entry> top(size_t k) const {
+        vector<Entry> out(heap);
+        k = min(k, out.size());
+        partial_sort(out.begin(), out.begin() + static_cast<ptrdiff_t>(k), out.end(),
+                     [](const Entry& a, const Entry& b) { return a.count > b.count; });
+        out.resize(k);
+        return out;
+    }
+
+    uint64_t total() const { return n; }
+    size_t capacity() const { return cap; }
+
+private:
+    void swapSlots(size_t a, size_t b) {
+        swap(heap[a], heap[b]);
+        slot[heap[a].key] = a;
+        slot[heap[b].key] = b;
+    }
+
+    void siftUp(size_t i) {
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (heap[parent].count <= heap[i].count) break;
+            swapSlots(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(size_t i) {
+        for (;;) {
+            size_t smallest = i, l = 2 * i + 1, r = l + 1;
+            if (l < heap.size() && heap[l].count < heap[smallest].count) smallest = l;
+            if (r < heap.size() && heap[r].count < heap[smallest].count) smallest = r;
+            if (smallest == i) break;
+            swapSlots(i, smallest);
+            i = smallest;
+        }
+    }
+
+    size_t   cap;
+    uint64_t n = 0;                       ///< Records added
+    vector<Entry> heap;                   ///< Min-heap on count
+    unordered_map<Key, size_t, Hash> slot;  ///< Key -> index in heap
+};
+
+/**
+ * Exact top-k of a full aggregation table by partial sort, O(n log k).
+ * Ties are broken by key so the output is deterministic.
+ */
+inline vector<pair<string, int>> topExact(const unordered_map<string, int>& counts, size_t k) {
+    vector<pair<string, int>> items(counts.begin(), counts.end());
+    k = min(k, items.size());
+    partial_sort(items.begin(), items.begin() + static_cast<ptrdiff_t>(k), items.end(),
+                 [](const pair<string, int>& a, const pair<string, int>& b) {
+                     return a.second != b.second ? a.second > b.second : a.first < b.first;
+                 });
+    items.resize(k);
+    return items;
+}
+
+#endif // TOP_K_HPP
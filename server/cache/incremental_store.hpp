@@ -0,0 +1,90 @@
+// File: server/cache/incremental_store.hpp
+// IncrementalStore: Remembers, per growing log file and query, the aggregate
+// up to a byte offset plus a resumable hash of that prefix.
+
+#ifndef INCREMENTAL_STORE_HPP
+#define INCREMENTAL_STORE_HPP
+
+#include "../util/xxhash64.hpp"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// Aggregate of one file prefix for one TYPE/FROM/TO combination
+struct IncrementalState {
+    uint64_t offset = 0;                 ///< Bytes of the file already counted
+    XXHash64 prefixHash;                 ///< Streaming hash of those bytes (resumable)
+    unordered_map<string, int> counts;   ///< Merged analysis result so far
+};
+
+/**
+ * Thread-safe, bounded map from "file|TYPE|FROM|TO" to IncrementalState.
+ * The least recently used states are dropped beyond maxEntries; a client whose
+ * state was dropped is simply asked to resend the file from offset 0.
+ */
+class IncrementalStore {
+public:
+    explicit IncrementalStore(size_t maxEntries = 1024)
+        : limit(maxEntries) {}
+
+    /**
+     * Copies the state for key if its offset and prefix hash match what the
+     * client claims to have sent before. Offset 0 always matches (fresh start).
+     * @return false if the client must resynchronise from offset 0.
+     */
+    bool checkout(const string& key, uint64_t offset, uint64_t prefixHash, IncrementalState& out) {
+        lock_guard<mutex> lock(mtx);
+        if (offset == 0) {
+            out = IncrementalState();
+            return true;
+        }
+        auto it = states.find(key);
+        if (it == states.end()) return false;
+        const IncrementalState& st = it->second.first;
+        if (st.offset != offset || st.prefixHash.digest() != prefixHash) return false;
+        lru.splice(lru.begin(), lru, it->second.second);
+        out = st;
+        return true;
+    }
+
+    /**
+     * Stores an updated state unless another request advanced the same key
+     * in the meantime (expectedOffset no longer current).
+     * @return false if the update lost that race.
+     */
+    bool commit(const string& key, uint64_t expectedOffset, IncrementalState st) {
+        lock_guard<mutex> lock(mtx);
+        auto it = states.find(key);
+        if (it != states.end()) {
+            if (expectedOffset != 0 && it->second.first.offset != expectedOffset) return false;
+            it->second.first = move(st);
+            lru.splice(lru.begin(), lru, it->second.second);
+            return true;
+        }
+        if (expectedOffset != 0) return false;
+        lru.push_front(key);
+        states.emplace(key, make_pair(move(st), lru.begin()));
+        while (states.size() > limit) {
+            states.erase(lru.back());
+            lru.pop_back();
+        }
+        return true;
+    }
+
+    size_t size() const {
+        lock_guard<mutex> lock(mtx);
+        return states.size();
+    }
+
+private:
+    mutable mutex mtx;
+    size_t limit;
+    list<string> lru;  ///< Front = most recently used key
+    unordered_map<string, pair<IncrementalState, list<string>::iterator>> states;
+};
+
+#endif // INCREMENTAL_STORE_HPP
@@ -0,0 +1,118 @@
+// File: server/cache/result_cache.hpp
+// ResultCache: Bounded LRU cache of analysis responses keyed by body hash + normalized header.
+
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+ * Thread-safe LRU map from request key to the exact response text.
+ * Capacity is a byte budget covering keys and values; the least recently
+ * used entries are evicted until a new entry fits. A capacity of 0 disables
+ * the cache.
+ */
+class ResultCache {
+public:
+    struct Stats {
+        uint64_t hits      = 0;
+        uint64_t misses    = 0;
+        uint64_t evictions = 0;
+        uint64_t entries   = 0;
+        uint64_t bytes     = 0;   ///< Bytes currently held (keys + values)
+        uint64_t capacity  = 0;   ///< Byte budget
+
+        double hitRatio() const {
+            uint64_t lookups = hits + misses;
+            return lookups ? static_cast<double>(hits) / lookups : 0.0;
+        }
+    };
+
+    explicit ResultCache(uint64_t capacityBytes = 0)
+        : capacity(capacityBytes) {}
+
+    void setCapacity(uint64_t capacityBytes) {
+        lock_guard<mutex> lock(mtx);
+        capacity = capacityBytes;
+        evictTo(capacity);
+    }
+
+    bool enabled() const {
+        lock_guard<mutex> lock(mtx);
+        return capacity > 0;
+    }
+
+    /**
+     * Looks up a key and marks it most recently used on a hit.
+     * @return true and fills value on a hit.
+     */
+    bool get(const string& key, string& value) {
+        lock_guard<mutex> lock(mtx);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            ++stats.misses;
+            return false;
+        }
+        lru.splice(lru.begin(), lru, it->second);
+        value = it->second->second;
+        ++stats.hits;
+        return true;
+    }
+
+    // Inserts or replaces an entry; entries larger than the whole budget are not cached
+    void put(const string& key, const string& value) {
+        lock_guard<mutex> lock(mtx);
+        uint64_t size = entrySize(key, value);
+        if (size > capacity) return;
+        auto it = index.find(key);
+        if (it != index.end()) {
+            stats.bytes -= entrySize(it->second->first, it->second->second);
+            lru.erase(it->second);
+            index.erase(it);
+        }
+        evictTo(capacity - size);
+        lru.emplace_front(key, value);
+        index[key] = lru.begin();
+        stats.bytes += size;
+    }
+
+    Stats snapshot() const {
+        lock_guard<mutex> lock(mtx);
+        Stats s = stats;
+        s.entries  = index.size();
+        s.capacity = capacity;
+        return s;
+    }
+
+private:
+    using Entry = pair<string, string>;
+
+    // Rough per-entry footprint: key and value bytes plus list/map node overhead
+    static uint64_t entrySize(const string& key, const string& value) {
+        return 2 * key.size() + value.size() + 96;
+    }
+
+    void evictTo(uint64_t limit) {
+        while (stats.bytes > limit && !lru.empty()) {
+            const Entry& victim = lru.back();
+            stats.bytes -= entrySize(victim.first, victim.second);
+            index.erase(victim.first);
+            lru.pop_back();
+            ++stats.evictions;
+        }
+    }
+
+    mutable mutex mtx;
+    uint64_t capacity;
+    list<Entry> lru;                                        ///< Front = most recently used
+    unordered_map<string, list<Entry>::iterator> index;     ///< Key -> position in lru
+    Stats stats;
+};
+
+#endif // RESULT_CACHE_HPP
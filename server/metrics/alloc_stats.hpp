@@ -0,0 +1,73 @@
+// File: server/metrics/alloc_stats.hpp
+// Allocation accounting: per-thread operator new counts, compiled in with -DALLOC_STATS=1.
+
+#ifndef ALLOC_STATS_HPP
+#define ALLOC_STATS_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// Heap allocations made through operator new, and the bytes they asked for
+struct AllocCounts {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+
+    AllocCounts operator-(const AllocCounts& o) const { return {count - o.count, bytes - o.bytes}; }
+    AllocCounts& operator+=(const AllocCounts& o) {
+        count += o.count;
+        bytes += o.bytes;
+        return *this;
+    }
+};
+
+/**
+ * With ALLOC_STATS set, this header replaces the global operator new/delete
+ * with malloc/free wrappers that bump the calling thread's counters: no
+ * atomics, no lock, so the overhead is two adds per allocation. Since a
+ * request runs on one thread, the difference of threadAllocs() before and
+ * after a stretch of code is exactly what that code allocated. Frees are
+ * not tracked.
+ *
+ * The replacements are ordinary (non-inline) definitions, so include this
+ * header from one translation unit per program -- every binary here is one.
+ * Without ALLOC_STATS nothing is replaced and threadAllocs() is all zero.
+ */
+#if ALLOC_STATS
+
+constexpr bool ALLOC_STATS_ENABLED = true;
+
+inline thread_local AllocCounts threadAllocCounts;
+
+inline void* countedAlloc(size_t size) {
+    AllocCounts& c = threadAllocCounts;
+    ++c.count;
+    c.bytes += size;
+    while (true) {
+        if (void* p = malloc(size ? size : 1)) return p;
+        new_handler handler = get_new_handler();
+        if (!handler) throw bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+inline AllocCounts threadAllocs() { return threadAllocCounts; }
+
+#else
+
+constexpr bool ALLOC_STATS_ENABLED = false;
+
+inline AllocCounts threadAllocs() { return {}; }
+
+#endif // ALLOC_STATS
+
+#endif // ALLOC_STATS_HPP
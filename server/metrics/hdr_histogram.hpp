@@ -0,0 +1,147 @@
+// File: server/metrics/hdr_histogram.hpp
+// HdrHistogram: Fixed-memory log-linear histogram for latency percentiles.
+
+#ifndef HDR_HISTOGRAM_HPP
+#define HDR_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+using namespace std;
+
+/**
+ * HDR-style layout: values below 2^subBucketBits are counted exactly; above
+ * that each power-of-two range is split into 2^(subBucketBits-1) equal
+ * sub-buckets, so every value is kept to a relative precision of
+ * 2^-(subBucketBits-1) (7 bits: ~1.6%, 10 bits: ~0.2%). Values up to
+ * 2^maxValueBits are tracked; larger ones land in the last bucket.
+ *
+ * record() is wait-free for a single writer: counters are relaxed atomics,
+ * so another thread may merge() it or read percentiles at any time, seeing
+ * each counter's latest value, without ever blocking the writer.
+ */
+class HdrHistogram {
+public:
+    explicit HdrHistogram(int subBucketBits = 7, int maxValueBits = 40)
+        : subBits(std::max(2, subBucketBits)),
+          maxBits(std::max(maxValueBits, subBits)),
+          halfCount(size_t(1) << (subBits - 1)),
+          size((static_cast<size_t>(maxBits - subBits) + 2) * halfCount),
+          counts(new atomic<uint64_t>[size]) {
+        reset();
+    }
+
+    HdrHistogram(const HdrHistogram& other)
+        : HdrHistogram(other.subBits, other.maxBits) {
+        merge(other);
+    }
+    HdrHistogram& operator=(const HdrHistogram&) = delete;
+
+    void record(uint64_t value) { recordCount(value, 1); }
+
+    void recordCount(uint64_t value, uint64_t n) {
+        bump(counts[indexOf(value)], n);
+        bump(total, n);
+        bump(sum, value * n);
+        if (value > maxSeen.load(memory_order_relaxed)) maxSeen.store(value, memory_order_relaxed);
+        if (value < minSeen.load(memory_order_relaxed)) minSeen.store(value, memory_order_relaxed);
+    }
+
+    /**
+     * Adds other's counts; layouts may differ (values are re-bucketed). Like
+     * record(), only one thread may write into this histogram at a time.
+     */
+    void merge(const HdrHistogram& other) {
+        uint64_t added = 0;
+        for (size_t i = 0; i < other.size; ++i) {
+            uint64_t n = other.counts[i].load(memory_order_relaxed);
+            if (!n) continue;
+            bump(counts[indexOf(other.valueAt(i))], n);
+            added += n;
+        }
+        if (!added) return;
+        bump(total, added);
+        bump(sum, other.sum.load(memory_order_relaxed));
+        if (other.max() > max()) maxSeen.store(other.max(), memory_order_relaxed);
+        if (other.min() < min() || count() == added) minSeen.store(other.min(), memory_order_relaxed);
+    }
+
+    void reset() {
+        for (size_t i = 0; i < size; ++i) counts[i].store(0, memory_order_relaxed);
+        total.store(0, memory_order_relaxed);
+        sum.store(0, memory_order_relaxed);
+        maxSeen.store(0, memory_order_relaxed);
+        minSeen.store(UINT64_MAX, memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total.load(memory_order_relaxed); }
+    uint64_t max()   const { return maxSeen.load(memory_order_relaxed); }
+    uint64_t min()   const { return count() ? minSeen.load(memory_order_relaxed) : 0; }
+    uint64_t valueSum() const { return sum.load(memory_order_relaxed); }
+    double   mean()  const { return count() ? double(valueSum()) / double(count()) : 0.0; }
+
+    /**
+     * Value at or below which `p` percent of the recorded values fall,
+     * reported as the top of its bucket (so within the histogram's precision)
+     * and capped at the largest value seen.
+     */
+    uint64_t percentile(double p) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(ceil(std::min(100.0, std::max(0.0, p)) / 100.0 * double(n)));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < size; ++i) {
+            seen += counts[i].load(memory_order_relaxed);
+            if (seen >= rank) return std::min(highestEquivalent(i), max());
+        }
+        return max();
+    }
+
+    // Number of recorded values <= bound (for cumulative exporters)
+    uint64_t countAtOrBelow(uint64_t bound) const {
+        uint64_t seen = 0;
+        for (size_t i = 0; i < size && valueAt(i) <= bound; ++i) {
+            seen += counts[i].load(memory_order_relaxed);
+        }
+        return seen;
+    }
+
+private:
+    static void bump(atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(memory_order_relaxed) + n, memory_order_relaxed);  // single writer
+    }
+
+    size_t indexOf(uint64_t v) const {
+        int msb = v ? 63 - __builtin_clzll(v) : 0;
+        int bucket = msb < subBits ? 0 : msb - subBits + 1;
+        if (bucket > maxBits - subBits) return size - 1;
+        size_t sub = static_cast<size_t>(v >> bucket);   // < 2 * halfCount
+        return static_cast<size_t>(bucket) * halfCount + sub;
+    }
+
+    // Lowest value mapped to index i
+    uint64_t valueAt(size_t i) const {
+        if (i < 2 * halfCount) return i;
+        size_t bucket = i / halfCount - 1;
+        size_t sub    = i - bucket * halfCount;
+        return static_cast<uint64_t>(sub) << bucket;
+    }
+
+    // Highest value mapped to index i
+    uint64_t highestEquivalent(size_t i) const {
+        if (i < 2 * halfCount) return i;
+        size_t bucket = i / halfCount - 1;
+        return valueAt(i) + ((uint64_t(1) << bucket) - 1);
+    }
+
+    int    subBits, maxBits;
+    size_t halfCount, size;
+    unique_ptr<atomic<uint64_t>[]> counts;
+    atomic<uint64_t> total{0}, sum{0}, maxSeen{0}, minSeen{UINT64_MAX};
+};
+
+#endif // HDR_HISTOGRAM_HPP
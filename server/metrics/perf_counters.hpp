@@ -0,0 +1,127 @@
+// File: server/metrics/perf_counters.hpp
+// PerfCounters: Hardware counters (cycles, instructions, cache/branch misses) via perf_event_open.
+
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Counter deltas over one measured region
+struct PerfSample {
+    uint64_t cycles       = 0;
+    uint64_t instructions = 0;
+    uint64_t cacheMisses  = 0;   ///< Last-level cache misses
+    uint64_t branchMisses = 0;
+
+    PerfSample& operator+=(const PerfSample& o) {
+        cycles       += o.cycles;
+        instructions += o.instructions;
+        cacheMisses  += o.cacheMisses;
+        branchMisses += o.branchMisses;
+        return *this;
+    }
+
+    double ipc() const { return cycles ? double(instructions) / double(cycles) : 0.0; }
+};
+
+/**
+ * One perf event group counting the calling thread in user space: cycles
+ * (the group leader), instructions, cache misses and branch misses. The
+ * group is scheduled as a unit, so the ratios are consistent; if the kernel
+ * multiplexes it, counts are scaled by enabled/running time.
+ *
+ * Needs perf_event_paranoid <= 2 (or CAP_PERFMON) and a PMU the kernel
+ * exposes; many VMs and containers have none. Cache and branch misses are
+ * optional and read as 0 when the CPU lacks them.
+ */
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters() { close(); }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * Opens the group for the calling thread; counts stay bound to it.
+     * @return false (with err set) if cycles or instructions cannot be counted.
+     */
+    bool open(string& err) {
+        close();
+        static const uint64_t configs[EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                 PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        static const char* names[EVENTS] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+        for (int e = 0; e < EVENTS; ++e) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.config         = configs[e];
+            attr.disabled       = e == 0;   // members follow the leader
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                  PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, e == 0 ? -1 : fds[0], 0));
+            if (fd < 0 && e < 2) {
+                err = string(names[e]) + ": " + strerror(errno);
+                close();
+                return false;
+            }
+            fds[e] = fd;
+            if (fd >= 0) slot[e] = members++;
+        }
+        return true;
+    }
+
+    bool isOpen() const { return fds[0] >= 0; }
+
+    void start() {
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Counts since start(); all zero if the read fails
+    PerfSample stop() {
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t buf[3 + EVENTS] = {};   // nr, time_enabled, time_running, values...
+        PerfSample s;
+        if (read(fds[0], buf, sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) return s;
+        double scale = buf[2] && buf[2] < buf[1] ? double(buf[1]) / double(buf[2]) : 1.0;
+        auto value = [&](int e) -> uint64_t {
+            return slot[e] >= 0 && static_cast<uint64_t>(slot[e]) < buf[0]
+                       ? static_cast<uint64_t>(double(buf[3 + slot[e]]) * scale) : 0;
+        };
+        s.cycles       = value(0);
+        s.instructions = value(1);
+        s.cacheMisses  = value(2);
+        s.branchMisses = value(3);
+        return s;
+    }
+
+private:
+    static constexpr int EVENTS = 4;
+
+    void close() {
+        for (int e = EVENTS - 1; e >= 0; --e) {
+            if (fds[e] >= 0) ::close(fds[e]);
+            fds[e] = -1;
+            slot[e] = -1;
+        }
+        members = 0;
+    }
+
+    int fds[EVENTS]  = {-1, -1, -1, -1};
+    int slot[EVENTS] = {-1, -1, -1, -1};   ///< Position of each event in a group read
+    int members = 0;
+};
+
+#endif // PERF_COUNTERS_HPP
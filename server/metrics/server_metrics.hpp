@@ -0,0 +1,205 @@
+// File: server/metrics/server_metrics.hpp
+// ServerMetrics / PromText: Sharded request counters and Prometheus text rendering.
+
+#ifndef SERVER_METRICS_HPP
+#define SERVER_METRICS_HPP
+
+#include "hdr_histogram.hpp"
+#include "perf_counters.hpp"
+#include "thread_shards.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+// Label values; anything else is folded into the last entry, so the number of
+// series stays bounded whatever clients send
+static const char* const METRIC_COMMANDS[] = {"ANALYZE", "QUERY", "INGEST", "APPEND", "FOLLOW",
+                                              "STATS", "LIST", "DROP", "TRACE", "OTHER"};
+static const char* const METRIC_FORMATS[]  = {"json", "xml", "txt", "bin", "none"};  // FileType order
+static const char* const METRIC_TYPES[]    = {"LOG_LEVEL", "USER", "IP", "HISTOGRAM", "DISTINCT", "none"};
+
+constexpr size_t METRIC_COMMAND_COUNT = sizeof(METRIC_COMMANDS) / sizeof(METRIC_COMMANDS[0]);
+constexpr size_t METRIC_FORMAT_COUNT  = sizeof(METRIC_FORMATS) / sizeof(METRIC_FORMATS[0]);
+constexpr size_t METRIC_TYPE_COUNT    = sizeof(METRIC_TYPES) / sizeof(METRIC_TYPES[0]);
+
+// Index of value in labels, or the last (catch-all) index
+template <size_t N>
+inline size_t metricLabelIndex(const char* const (&labels)[N], const string& value) {
+    for (size_t i = 0; i + 1 < N; ++i) {
+        if (value == labels[i]) return i;
+    }
+    return N - 1;
+}
+
+/**
+ * Server-wide counters: connections, requests by command/format/type, bytes
+ * in and out, and parse volume and time. Every thread bumps its own shard
+ * (see ThreadShards) with relaxed loads and stores; snapshot() sums them.
+ */
+class ServerMetrics {
+public:
+    struct Totals {
+        uint64_t opened = 0, closed = 0;
+        uint64_t bytesIn = 0, bytesOut = 0, errors = 0;
+        uint64_t parseBytes = 0, parseMicros = 0;
+        PerfSample parseCounters;
+        array<uint64_t, METRIC_COMMAND_COUNT * METRIC_FORMAT_COUNT * METRIC_TYPE_COUNT> requests{};
+
+        uint64_t activeConnections() const { return opened - closed; }
+    };
+
+    // Bumps the connection gauge for the lifetime of a handleClient call
+    class Connection {
+    public:
+        explicit Connection(ServerMetrics& m) : metrics(m) { bump(metrics.shards.local().opened, 1); }
+        ~Connection() { bump(metrics.shards.local().closed, 1); }
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+    private:
+        ServerMetrics& metrics;
+    };
+
+    void addBytesIn(uint64_t n)  { bump(shards.local().bytesIn, n); }
+    void addBytesOut(uint64_t n) { bump(shards.local().bytesOut, n); }
+    void countError()            { bump(shards.local().errors, 1); }
+
+    // Bytes handed to a parser and the time spent filtering and parsing them
+    void addParse(uint64_t bytes, uint64_t micros) {
+        Slot& slot = shards.local();
+        bump(slot.parseBytes, bytes);
+        bump(slot.parseMicros, micros);
+    }
+
+    // Hardware counter deltas over the same filtering and parsing
+    void addParseCounters(const PerfSample& p) {
+        Slot& slot = shards.local();
+        bump(slot.cycles, p.cycles);
+        bump(slot.instructions, p.instructions);
+        bump(slot.cacheMisses, p.cacheMisses);
+        bump(slot.branchMisses, p.branchMisses);
+    }
+
+    // command, format and type are label indexes (see metricLabelIndex)
+    void countRequest(size_t command, size_t format, size_t type) {
+        bump(shards.local().requests[requestIndex(command, format, type)], 1);
+    }
+
+    static size_t requestIndex(size_t command, size_t format, size_t type) {
+        return (command * METRIC_FORMAT_COUNT + format) * METRIC_TYPE_COUNT + type;
+    }
+
+    Totals snapshot() {
+        Totals t;
+        shards.forEach([&](const Slot& s) {
+            t.opened      += s.opened.load(memory_order_relaxed);
+            t.closed      += s.closed.load(memory_order_relaxed);
+            t.bytesIn     += s.bytesIn.load(memory_order_relaxed);
+            t.bytesOut    += s.bytesOut.load(memory_order_relaxed);
+            t.errors      += s.errors.load(memory_order_relaxed);
+            t.parseBytes  += s.parseBytes.load(memory_order_relaxed);
+            t.parseMicros += s.parseMicros.load(memory_order_relaxed);
+            t.parseCounters.cycles       += s.cycles.load(memory_order_relaxed);
+            t.parseCounters.instructions += s.instructions.load(memory_order_relaxed);
+            t.parseCounters.cacheMisses  += s.cacheMisses.load(memory_order_relaxed);
+            t.parseCounters.branchMisses += s.branchMisses.load(memory_order_relaxed);
+            for (size_t i = 0; i < t.requests.size(); ++i) {
+                t.requests[i] += s.requests[i].load(memory_order_relaxed);
+            }
+        });
+        return t;
+    }
+
+private:
+    struct Slot {
+        atomic<uint64_t> opened{0}, closed{0};
+        atomic<uint64_t> bytesIn{0}, bytesOut{0}, errors{0};
+        atomic<uint64_t> parseBytes{0}, parseMicros{0};
+        atomic<uint64_t> cycles{0}, instructions{0}, cacheMisses{0}, branchMisses{0};
+        array<atomic<uint64_t>, METRIC_COMMAND_COUNT * METRIC_FORMAT_COUNT * METRIC_TYPE_COUNT> requests{};
+
+        void merge(const Slot& o) {
+            bump(opened, o.opened.load(memory_order_relaxed));
+            bump(closed, o.closed.load(memory_order_relaxed));
+            bump(bytesIn, o.bytesIn.load(memory_order_relaxed));
+            bump(bytesOut, o.bytesOut.load(memory_order_relaxed));
+            bump(errors, o.errors.load(memory_order_relaxed));
+            bump(parseBytes, o.parseBytes.load(memory_order_relaxed));
+            bump(parseMicros, o.parseMicros.load(memory_order_relaxed));
+            bump(cycles, o.cycles.load(memory_order_relaxed));
+            bump(instructions, o.instructions.load(memory_order_relaxed));
+            bump(cacheMisses, o.cacheMisses.load(memory_order_relaxed));
+            bump(branchMisses, o.branchMisses.load(memory_order_relaxed));
+            for (size_t i = 0; i < requests.size(); ++i) {
+                bump(requests[i], o.requests[i].load(memory_order_relaxed));
+            }
+        }
+    };
+
+    static void bump(atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(memory_order_relaxed) + n, memory_order_relaxed);  // single writer
+    }
+
+    ThreadShards<Slot> shards;
+};
+
+// Resident set size from /proc/self/statm (0 if unavailable)
+inline uint64_t residentBytes() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long long size = 0, resident = 0;
+    int got = fscanf(f, "%llu %llu", &size, &resident);
+    fclose(f);
+    return got == 2 ? resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+/**
+ * Builds a Prometheus text exposition (format 0.0.4): a family header per
+ * metric, then its samples. Label values must not need escaping.
+ */
+class PromText {
+public:
+    void family(const string& name, const char* type, const char* help) {
+        out << "# HELP " << name << " " << help << "\n"
+            << "# TYPE " << name << " " << type << "\n";
+    }
+
+    template <typename T>
+    void sample(const string& name, const string& labels, T value) {
+        out << name;
+        if (!labels.empty()) out << "{" << labels << "}";
+        out << " " << value << "\n";
+    }
+
+    /**
+     * Cumulative _bucket, _sum and _count samples of a histogram recorded in
+     * microseconds, with `le` bounds in seconds. Each bucket also counts the
+     * values sharing the histogram bucket of its bound, so counts are exact to
+     * within the histogram's precision.
+     */
+    void histogram(const string& name, const string& labels, const HdrHistogram& h) {
+        static const uint64_t boundsMicros[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+                                                100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+        string sep = labels.empty() ? "" : ",";
+        for (uint64_t b : boundsMicros) {
+            ostringstream le;
+            le << labels << sep << "le=\"" << b / 1e6 << "\"";
+            sample(name + "_bucket", le.str(), h.countAtOrBelow(b));
+        }
+        sample(name + "_bucket", labels + sep + "le=\"+Inf\"", h.count());
+        sample(name + "_sum", labels, h.valueSum() / 1e6);
+        sample(name + "_count", labels, h.count());
+    }
+
+    string str() const { return out.str(); }
+
+private:
+    ostringstream out;
+};
+
+#endif // SERVER_METRICS_HPP
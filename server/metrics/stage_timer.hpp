@@ -0,0 +1,208 @@
+// File: server/metrics/stage_timer.hpp
+// StageTimer / StageStats: Per-stage request latency with per-thread histograms.
+
+#ifndef STAGE_TIMER_HPP
+#define STAGE_TIMER_HPP
+
+#include "alloc_stats.hpp"
+#include "hdr_histogram.hpp"
+#include "thread_shards.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Stages of handleClient, in order
+enum class Stage { RECV, HEADER, CACHE, FILTER, PARSE, SEND, COUNT };
+
+constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::COUNT);
+
+inline const char* stageName(size_t s) {
+    static const char* names[] = {"recv", "header", "cache", "filter", "parse", "send", "total"};
+    return names[min(s, STAGE_COUNT)];
+}
+
+/**
+ * Times one request. lap(stage) charges the time since the previous lap (or
+ * construction) to that stage. Stages never lapped (e.g. filter and parse on
+ * a cache hit) are reported as not run rather than as zero. In an
+ * ALLOC_STATS build each lap also charges the thread's heap allocations.
+ */
+class StageTimer {
+public:
+    using Clock = chrono::steady_clock;
+
+    StageTimer() : start(Clock::now()), last(start), firstAllocs(threadAllocs()), lastAllocs(firstAllocs) {}
+
+    void lap(Stage s) {
+        Clock::time_point now = Clock::now();
+        size_t i = static_cast<size_t>(s);
+        micros[i] += chrono::duration_cast<chrono::microseconds>(now - last).count();
+        if (!stageRan(i)) begins[i] = last;
+        ran |= 1u << static_cast<unsigned>(s);
+        last = now;
+        if constexpr (ALLOC_STATS_ENABLED) {
+            AllocCounts a = threadAllocs();
+            allocs[i] += a - lastAllocs;
+            lastAllocs = a;
+        }
+    }
+
+    bool     stageRan(size_t s)    const { return ran & (1u << s); }
+    uint64_t stageMicros(size_t s) const { return micros[s]; }
+    // When the stage was first lapped from (for trace spans)
+    Clock::time_point stageBegin(size_t s) const { return begins[s]; }
+    Clock::time_point startTime() const { return start; }
+    Clock::time_point endTime()   const { return last; }
+    uint64_t totalMicros() const {
+        return chrono::duration_cast<chrono::microseconds>(last - start).count();
+    }
+    AllocCounts stageAllocs(size_t s) const { return allocs[s]; }
+    AllocCounts totalAllocs() const { return lastAllocs - firstAllocs; }
+
+    // "recv=1.20ms header=0.01ms ..." for the slow-request log
+    string breakdown() const {
+        ostringstream out;
+        out << fixed << setprecision(2);
+        for (size_t s = 0; s < STAGE_COUNT; ++s) {
+            out << (s ? " " : "") << stageName(s) << "=";
+            if (stageRan(s)) out << micros[s] / 1000.0 << "ms";
+            else             out << "-";
+        }
+        return out.str();
+    }
+
+    // "recv=3/96B header=41/2.1KB ... total=..." (allocations/bytes) for the slow-request log
+    string allocBreakdown() const {
+        auto size = [](uint64_t b) {
+            ostringstream os;
+            os << fixed << setprecision(1);
+            if (b < 1024)              os << b << "B";
+            else if (b < (1ULL << 20)) os << b / 1024.0 << "KB";
+            else                       os << b / 1048576.0 << "MB";
+            return os.str();
+        };
+        ostringstream out;
+        for (size_t s = 0; s < STAGE_COUNT; ++s) {
+            out << stageName(s) << "=";
+            if (stageRan(s)) out << allocs[s].count << "/" << size(allocs[s].bytes) << " ";
+            else             out << "- ";
+        }
+        AllocCounts t = totalAllocs();
+        out << "total=" << t.count << "/" << size(t.bytes);
+        return out.str();
+    }
+
+private:
+    Clock::time_point start, last;
+    AllocCounts firstAllocs, lastAllocs;
+    array<AllocCounts, STAGE_COUNT> allocs{};
+    array<uint64_t, STAGE_COUNT> micros{};
+    array<Clock::time_point, STAGE_COUNT> begins{};
+    unsigned ran = 0;  ///< Bit per stage that was lapped
+};
+
+/**
+ * Per-stage (and total) latency histograms in microseconds, sharded per
+ * thread (see ThreadShards) so the hot path takes no lock. format() merges
+ * all shards; writers keep running meanwhile. ALLOC_STATS builds also sum
+ * each stage's allocations.
+ */
+class StageStats {
+public:
+    void record(const StageTimer& t) {
+        Slot& slot = shards.local();
+        for (size_t s = 0; s < STAGE_COUNT; ++s) {
+            if (t.stageRan(s)) slot.hist[s].record(t.stageMicros(s));
+        }
+        slot.hist[STAGE_COUNT].record(t.totalMicros());
+        if constexpr (ALLOC_STATS_ENABLED) {
+            for (size_t s = 0; s <= STAGE_COUNT; ++s) {
+                AllocCounts a = s < STAGE_COUNT ? t.stageAllocs(s) : t.totalAllocs();
+                bump(slot.allocCount[s], a.count);
+                bump(slot.allocBytes[s], a.bytes);
+            }
+        }
+    }
+
+    // Allocations of all threads, past and present: [stage] then total
+    vector<AllocCounts> allocTotals() {
+        vector<AllocCounts> out(STAGE_COUNT + 1);
+        shards.forEach([&](const Slot& slot) {
+            for (size_t s = 0; s <= STAGE_COUNT; ++s) {
+                out[s] += {slot.allocCount[s].load(memory_order_relaxed), slot.allocBytes[s].load(memory_order_relaxed)};
+            }
+        });
+        return out;
+    }
+
+    // Merged histograms of all threads, past and present: [stage] then total
+    vector<unique_ptr<HdrHistogram>> snapshot() {
+        vector<unique_ptr<HdrHistogram>> out;
+        for (size_t s = 0; s <= STAGE_COUNT; ++s) out.push_back(make_unique<HdrHistogram>(6, 32));
+        shards.forEach([&](const Slot& slot) {
+            for (size_t s = 0; s <= STAGE_COUNT; ++s) out[s]->merge(slot.hist[s]);
+        });
+        return out;
+    }
+
+    // "stage_<name>_count: n" and p50/p90/p99/max lines for CMD:STATS
+    string format() {
+        auto hists = snapshot();
+        ostringstream out;
+        for (size_t s = 0; s <= STAGE_COUNT; ++s) {
+            const HdrHistogram& h = *hists[s];
+            string prefix = string("stage_") + stageName(s);
+            out << prefix << "_count: "   << h.count() << "\n"
+                << prefix << "_p50_us: "  << h.percentile(50) << "\n"
+                << prefix << "_p90_us: "  << h.percentile(90) << "\n"
+                << prefix << "_p99_us: "  << h.percentile(99) << "\n"
+                << prefix << "_max_us: "  << h.max() << "\n";
+        }
+        if constexpr (ALLOC_STATS_ENABLED) {
+            // Averaged over the requests that ran the stage
+            vector<AllocCounts> allocs = allocTotals();
+            for (size_t s = 0; s <= STAGE_COUNT; ++s) {
+                double per = hists[s]->count() ? 1.0 / double(hists[s]->count()) : 0.0;
+                string prefix = string("stage_") + stageName(s);
+                out << prefix << "_allocs_per_request: "      << allocs[s].count * per << "\n"
+                    << prefix << "_alloc_bytes_per_request: " << allocs[s].bytes * per << "\n";
+            }
+        }
+        return out.str();
+    }
+
+private:
+    // ~3% precision up to 2^32 us (71 min): about 7 KB per histogram
+    struct Slot {
+        vector<HdrHistogram> hist;  ///< [stage], then total
+        array<atomic<uint64_t>, STAGE_COUNT + 1> allocCount{}, allocBytes{};
+        Slot() {
+            hist.reserve(STAGE_COUNT + 1);
+            for (size_t s = 0; s <= STAGE_COUNT; ++s) hist.emplace_back(6, 32);
+        }
+        void merge(const Slot& other) {
+            for (size_t s = 0; s <= STAGE_COUNT; ++s) {
+                hist[s].merge(other.hist[s]);
+                bump(allocCount[s], other.allocCount[s].load(memory_order_relaxed));
+                bump(allocBytes[s], other.allocBytes[s].load(memory_order_relaxed));
+            }
+        }
+    };
+
+    static void bump(atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(memory_order_relaxed) + n, memory_order_relaxed);  // single writer
+    }
+
+    ThreadShards<Slot> shards;
+};
+
+#endif // STAGE_TIMER_HPP
@@ -0,0 +1,73 @@
+// File: server/metrics/thread_shards.hpp
+// ThreadShards: Per-thread metric slots, merged on read, folded in on thread exit.
+
+#ifndef THREAD_SHARDS_HPP
+#define THREAD_SHARDS_HPP
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+/**
+ * One Slot per thread, so writers never lock or share cache lines. A slot is
+ * registered on the thread's first local() call. Connection threads are
+ * short-lived, so when a thread exits its slot is merged into a "retired"
+ * slot and unregistered.
+ *
+ * Slot needs a default constructor and merge(const Slot&); its fields should
+ * be relaxed atomics (or otherwise safe to read while the owner writes), since
+ * forEach() reads live slots without stopping their threads.
+ *
+ * Slots are bound to the first instance a thread uses, so keep one instance
+ * per Slot type per process.
+ */
+template <typename Slot>
+class ThreadShards {
+public:
+    ThreadShards() : retired(make_unique<Slot>()) {}
+
+    // The calling thread's slot
+    Slot& local() {
+        thread_local Handle handle;
+        if (!handle.slot) {
+            handle.slot  = make_unique<Slot>();
+            handle.owner = this;
+            lock_guard<mutex> lock(mtx);
+            live.push_back(handle.slot.get());
+        }
+        return *handle.slot;
+    }
+
+    // Calls fn(const Slot&) on the retired slot and every live one, under the registry lock
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        lock_guard<mutex> lock(mtx);
+        fn(static_cast<const Slot&>(*retired));
+        for (const Slot* slot : live) fn(*slot);
+    }
+
+private:
+    // Retires the thread's slot when the thread exits
+    struct Handle {
+        ThreadShards* owner = nullptr;
+        unique_ptr<Slot> slot;
+        ~Handle() {
+            if (owner) owner->retire(slot.get());
+        }
+    };
+
+    void retire(Slot* slot) {
+        lock_guard<mutex> lock(mtx);
+        retired->merge(*slot);
+        live.erase(remove(live.begin(), live.end(), slot), live.end());
+    }
+
+    mutex mtx;
+    unique_ptr<Slot> retired;   ///< Threads that have exited
+    vector<Slot*> live;         ///< Slots of running threads (owned by their Handle)
+};
+
+#endif // THREAD_SHARDS_HPP
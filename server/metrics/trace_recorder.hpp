@@ -0,0 +1,157 @@
+// File: server/metrics/trace_recorder.hpp
+// TraceRecorder: Flight recorder of request spans, exported as Chrome trace-event JSON.
+
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include "stage_timer.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * One complete ("ph":"X") span. Names and the label are string literals or
+ * other static strings, so recording never allocates.
+ */
+struct TraceEvent {
+    const char* name;
+    uint64_t    beginMicros;   ///< Since the recorder was created
+    uint64_t    durMicros;
+    uint32_t    tid;           ///< Recorder-assigned thread number
+    const char* argName;       ///< Optional numeric argument
+    uint64_t    argValue;
+    const char* label;         ///< Optional "type" argument
+};
+
+/**
+ * Spans are appended to a plain thread-local vector (no lock, no atomics)
+ * and moved into a shared ring of the most recent `capacity` events when
+ * the thread exits -- connection threads live for one request -- or when
+ * the local buffer reaches FLUSH_EVENTS (long FOLLOW sessions). dumpJson()
+ * renders the ring in the Chrome trace-event format, which Perfetto
+ * (ui.perfetto.dev) and chrome://tracing open directly: one track per
+ * connection thread.
+ *
+ * Disabled (capacity 0) unless enable() is called before serving.
+ */
+class TraceRecorder {
+public:
+    using Clock = chrono::steady_clock;
+    static constexpr size_t FLUSH_EVENTS = 4096;
+
+    TraceRecorder() : epoch(Clock::now()) {}
+
+    void enable(size_t capacity) {
+        lock_guard<mutex> lock(mtx);
+        ring.assign(capacity, TraceEvent{});
+        next  = 0;
+        total = 0;
+        on.store(capacity > 0, memory_order_relaxed);
+    }
+
+    bool enabled() const { return on.load(memory_order_relaxed); }
+
+    void span(const char* name, Clock::time_point begin, Clock::time_point end,
+              const char* argName = nullptr, uint64_t argValue = 0, const char* label = nullptr) {
+        if (!enabled()) return;
+        Local& l = local();
+        l.events.push_back({name, micros(begin), micros(end) - micros(begin), l.tid, argName, argValue, label});
+        if (l.events.size() >= FLUSH_EVENTS) flush(l);
+    }
+
+    /**
+     * The request as a whole, named after its command, with one child span
+     * per stage that ran.
+     */
+    void stages(const StageTimer& t, const char* command, const char* type, uint64_t bodyBytes) {
+        if (!enabled()) return;
+        span(command, t.startTime(), t.endTime(), "body_bytes", bodyBytes, type);
+        for (size_t s = 0; s < STAGE_COUNT; ++s) {
+            if (!t.stageRan(s)) continue;
+            Clock::time_point b = t.stageBegin(s);
+            span(stageName(s), b, b + chrono::microseconds(t.stageMicros(s)));
+        }
+    }
+
+    // Chrome trace-event JSON of the recorded spans, oldest first
+    string dumpJson() {
+        lock_guard<mutex> lock(mtx);
+        ostringstream out;
+        size_t kept = min<uint64_t>(total, ring.size());
+        size_t first = total > ring.size() ? next : 0;
+        set<uint32_t> tids;
+        out << "{\"traceEvents\":[\n"
+            << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"server_app\"}}";
+        for (size_t i = 0; i < kept; ++i) {
+            const TraceEvent& e = ring[(first + i) % ring.size()];
+            out << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"server\",\"ph\":\"X\",\"ts\":" << e.beginMicros
+                << ",\"dur\":" << e.durMicros << ",\"pid\":1,\"tid\":" << e.tid;
+            if (e.argName || e.label) {
+                out << ",\"args\":{";
+                if (e.argName) out << "\"" << e.argName << "\":" << e.argValue;
+                if (e.label)   out << (e.argName ? "," : "") << "\"type\":\"" << e.label << "\"";
+                out << "}";
+            }
+            out << "}";
+            tids.insert(e.tid);
+        }
+        for (uint32_t tid : tids) {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":\"conn " << tid << "\"}}";
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"recorded_events\":" << total
+            << ",\"dropped_events\":" << total - kept << "}}\n";
+        return out.str();
+    }
+
+private:
+    struct Local {
+        TraceRecorder* owner = nullptr;
+        uint32_t tid = 0;
+        vector<TraceEvent> events;
+        ~Local() {
+            if (owner) owner->flush(*this);
+        }
+    };
+
+    Local& local() {
+        thread_local Local l;
+        if (!l.owner) {
+            l.owner = this;
+            l.tid   = nextTid.fetch_add(1, memory_order_relaxed);
+        }
+        return l;
+    }
+
+    void flush(Local& l) {
+        lock_guard<mutex> lock(mtx);
+        for (const TraceEvent& e : l.events) {
+            if (ring.empty()) break;
+            ring[next] = e;
+            next = (next + 1) % ring.size();
+            ++total;
+        }
+        l.events.clear();
+    }
+
+    uint64_t micros(Clock::time_point t) const {
+        return t < epoch ? 0 : chrono::duration_cast<chrono::microseconds>(t - epoch).count();
+    }
+
+    const Clock::time_point epoch;
+    atomic<bool> on{false};
+    atomic<uint32_t> nextTid{1};
+    mutex mtx;                   ///< Guards the ring
+    vector<TraceEvent> ring;
+    size_t   next  = 0;          ///< Slot the next event goes to
+    uint64_t total = 0;          ///< Events ever flushed into the ring
+};
+
+#endif // TRACE_RECORDER_HPP
@@ -0,0 +1,483 @@
+// File: server/parser/bin_format.hpp
+// Columnar binary log format ("PLOGBIN"): on-disk layout, varint helpers,
+// a writer that builds a file from LogRecords and a zero-copy reader view.
+
+#ifndef BIN_FORMAT_HPP
+#define BIN_FORMAT_HPP
+
+#include "log_record.hpp"
+#include "../util/xxhash64.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/*
+ * File layout (all integers little-endian):
+ *
+ *   BinHeader                      fixed 56 bytes, offsets below are from file start
+ *   level dictionary               uint8 count, then count x (uint8 len, bytes)
+ *   blocks                         each 8-aligned, see below
+ *   block index                    blockCount x BlockInfo (8-aligned)
+ *
+ * Records are sorted by timestamp and cut into blocks of blockRecords records.
+ * Each block stores its own columns:
+ *
+ *   timestamp column               zigzag LEB128 delta from the previous record (first from minTimestamp)
+ *   level column                   one dictionary index byte per record
+ *   user column                    LEB128 varint per record
+ *   ip column      (4-aligned)     uint32 per record
+ *   message index  (8-aligned)     (recordCount + 1) x uint64 offsets into the block's blob
+ *   message blob                   concatenated message bytes
+ *
+ * BlockInfo is the block's zone map: min/max timestamp, user and IP plus the set
+ * of levels present. BINParser skips blocks outside FROM/TO and blocks a WHERE
+ * filter rules out (RecordFilter::mayMatch) without reading their columns.
+ * It also holds the block's checksum (version 3 on), so a reader can verify just
+ * the blocks it reads. The message columns are optional (BIN_FLAG_MESSAGES);
+ * without them both offsets are 0.
+ */
+
+constexpr char     BIN_MAGIC[8]              = {'P', 'L', 'O', 'G', 'B', 'I', 'N', '1'};
+constexpr uint32_t BIN_VERSION               = 3;
+constexpr uint32_t BIN_MIN_VERSION           = 2;  ///< Oldest readable; version 2 blocks have no checksum
+constexpr uint32_t BIN_FLAG_MESSAGES         = 1u << 0;
+constexpr uint32_t BIN_DEFAULT_BLOCK_RECORDS = 4096;
+
+struct BinHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t recordCount;
+    uint32_t blockCount;
+    uint32_t blockRecords;      ///< Records per block (the last block may be shorter)
+    uint64_t levelDictOffset;
+    uint64_t blockIndexOffset;
+    uint64_t fileSize;
+};
+static_assert(sizeof(BinHeader) == 56, "BinHeader must stay 56 bytes");
+
+// Zone map and column offsets (absolute) of one block
+struct BlockInfo {
+    int64_t  minTimestamp;
+    int64_t  maxTimestamp;
+    uint64_t firstRecord;       ///< Index of the block's first record within the file
+    uint32_t recordCount;
+    uint32_t minUser;
+    uint32_t maxUser;
+    uint32_t minIp;
+    uint32_t maxIp;
+    uint32_t checksum;          ///< blockChecksum() of this block (0 in version 2 files)
+    uint64_t levelMask[4];      ///< Bit i set if level dictionary index i occurs in the block
+    uint64_t timestampOffset;
+    uint64_t levelOffset;
+    uint64_t userOffset;
+    uint64_t ipOffset;
+    uint64_t messageIndexOffset;
+    uint64_t messageBlobOffset;
+    uint64_t endOffset;
+
+    bool hasLevel(uint8_t idx) const { return levelMask[idx >> 6] & (1ULL << (idx & 63)); }
+};
+static_assert(sizeof(BlockInfo) == 136, "BlockInfo must stay 136 bytes");
+
+// Low 32 bits of XXH64 over b (checksum field zeroed) and its bytes [timestampOffset, endOffset)
+inline uint32_t blockChecksum(BlockInfo b, const uint8_t* image) {
+    b.checksum = 0;
+    XXHash64 h;
+    h.update(&b, sizeof(b));
+    h.update(image + b.timestampOffset, b.endOffset - b.timestampOffset);
+    return static_cast<uint32_t>(h.digest());
+}
+
+// True if the buffer starts with the PLOGBIN magic
+inline bool hasBinMagic(const char* data, size_t size) {
+    return size >= sizeof(BIN_MAGIC) && memcmp(data, BIN_MAGIC, sizeof(BIN_MAGIC)) == 0;
+}
+
+// ---- Varint helpers ----
+
+inline void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+// Decodes one LEB128 varint; advances p. Caller guarantees p < end on entry.
+inline uint64_t getVarint(const uint8_t*& p, const uint8_t* end) {
+    uint64_t v = 0;
+    unsigned shift = 0;
+    while (p < end) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+        shift += 7;
+        if (shift > 63) break;
+    }
+    return v;
+}
+
+inline uint64_t zigzagEncode(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t  zigzagDecode(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+/**
+ * BinWriter buffers records as fixed-size rows, then sorts them by timestamp
+ * and serialises them block by block into the PLOGBIN layout.
+ * Memory use is roughly 32 bytes per record plus the message bytes.
+ */
+class BinWriter {
+public:
+    /**
+     * Constructor
+     * @param withMessages Whether to store the optional message column.
+     * @param blockRecords Records per block; smaller blocks prune more precisely
+     *                     at the cost of a larger block index.
+     */
+    explicit BinWriter(bool withMessages = true,
+                       uint32_t blockRecords = BIN_DEFAULT_BLOCK_RECORDS)
+        : messages(withMessages), blockRecords(max<uint32_t>(blockRecords, 1)) {}
+
+    /**
+     * Appends one record. Records without a timestamp are dropped (blocks are
+     * time ordered); a user id or IP that did not convert is stored as 0.
+     * Throws runtime_error if more than 255 distinct log levels are seen (the
+     * level column is a single dictionary byte).
+     */
+    void add(const LogRecord& rec) {
+        if (!rec.has(LogRecord::TIMESTAMP)) return;
+        Row row;
+        row.timestamp    = rec.timestamp;
+        row.userId       = rec.userId;
+        row.ip           = rec.ip;
+        row.level        = levelIndex(rec.level);
+        row.messageStart = messageBlob.size();
+        row.messageLen   = 0;
+        if (messages) {
+            messageBlob.append(rec.message.data(), rec.message.size());
+            row.messageLen = static_cast<uint32_t>(rec.message.size());
+        }
+        rows.push_back(row);
+    }
+
+    uint64_t recordCount() const { return rows.size(); }
+
+    // Serialises everything added so far into a complete PLOGBIN image
+    string finish() const {
+        // Time order makes each block cover a narrow, non-overlapping time range
+        vector<uint32_t> order(rows.size());
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return rows[a].timestamp < rows[b].timestamp;
+        });
+
+        string out(sizeof(BinHeader), '\0');
+        BinHeader h{};
+        memcpy(h.magic, BIN_MAGIC, sizeof(BIN_MAGIC));
+        h.version      = BIN_VERSION;
+        h.flags        = messages ? BIN_FLAG_MESSAGES : 0;
+        h.recordCount  = rows.size();
+        h.blockRecords = blockRecords;
+
+        h.levelDictOffset = out.size();
+        out.push_back(static_cast<char>(levels.size()));
+        for (const auto& lv : levels) {
+            out.push_back(static_cast<char>(lv.size()));
+            out += lv;
+        }
+
+        vector<BlockInfo> index;
+        for (size_t first = 0; first < order.size(); first += blockRecords) {
+            size_t last = min(order.size(), first + blockRecords);
+            index.push_back(writeBlock(out, order, first, last));
+        }
+
+        alignTo(out, 8);
+        h.blockCount       = static_cast<uint32_t>(index.size());
+        h.blockIndexOffset = out.size();
+        out.append(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(BlockInfo));
+        h.fileSize = out.size();
+        memcpy(&out[0], &h, sizeof(h));
+        return out;
+    }
+
+private:
+    // One buffered record; the level is already a dictionary index
+    struct Row {
+        int64_t  timestamp;
+        uint64_t messageStart;
+        uint32_t messageLen;
+        uint32_t userId;
+        uint32_t ip;
+        uint8_t  level;
+    };
+
+    static void alignTo(string& out, size_t a) {
+        out.resize((out.size() + a - 1) / a * a, '\0');
+    }
+
+    // Encodes rows order[first, last) as one block appended to out
+    BlockInfo writeBlock(string& out, const vector<uint32_t>& order, size_t first, size_t last) const {
+        BlockInfo b{};
+        b.firstRecord  = first;
+        b.recordCount  = static_cast<uint32_t>(last - first);
+        b.minTimestamp = rows[order[first]].timestamp;
+        b.maxTimestamp = rows[order[last - 1]].timestamp;
+        b.minUser = b.minIp = UINT32_MAX;
+        for (size_t i = first; i < last; ++i) {
+            const Row& r = rows[order[i]];
+            b.minUser = min(b.minUser, r.userId);
+            b.maxUser = max(b.maxUser, r.userId);
+            b.minIp   = min(b.minIp, r.ip);
+            b.maxIp   = max(b.maxIp, r.ip);
+            b.levelMask[r.level >> 6] |= 1ULL << (r.level & 63);
+        }
+
+        alignTo(out, 8);
+        b.timestampOffset = out.size();
+        int64_t prev = b.minTimestamp;
+        for (size_t i = first; i < last; ++i) {
+            putVarint(out, zigzagEncode(rows[order[i]].timestamp - prev));
+            prev = rows[order[i]].timestamp;
+        }
+        b.levelOffset = out.size();
+        for (size_t i = first; i < last; ++i) out.push_back(static_cast<char>(rows[order[i]].level));
+        b.userOffset = out.size();
+        for (size_t i = first; i < last; ++i) putVarint(out, rows[order[i]].userId);
+        alignTo(out, 4);
+        b.ipOffset = out.size();
+        for (size_t i = first; i < last; ++i) {
+            out.append(reinterpret_cast<const char*>(&rows[order[i]].ip), sizeof(uint32_t));
+        }
+        if (messages) {
+            alignTo(out, 8);
+            b.messageIndexOffset = out.size();
+            uint64_t off = 0;
+            out.append(reinterpret_cast<const char*>(&off), sizeof(off));
+            for (size_t i = first; i < last; ++i) {
+                off += rows[order[i]].messageLen;
+                out.append(reinterpret_cast<const char*>(&off), sizeof(off));
+            }
+            b.messageBlobOffset = out.size();
+            for (size_t i = first; i < last; ++i) {
+                const Row& r = rows[order[i]];
+                out.append(messageBlob, r.messageStart, r.messageLen);
+            }
+        }
+        b.endOffset = out.size();
+        b.checksum  = blockChecksum(b, reinterpret_cast<const uint8_t*>(out.data()));
+        return b;
+    }
+
+    uint8_t levelIndex(string_view level) {
+        auto it = levelIds.find(string(level));
+        if (it != levelIds.end()) return it->second;
+        if (levels.size() >= 255 || level.size() > 255) {
+            throw runtime_error("PLOGBIN supports at most 255 log levels of up to 255 bytes");
+        }
+        levels.emplace_back(level);
+        uint8_t id = static_cast<uint8_t>(levels.size() - 1);
+        levelIds.emplace(levels.back(), id);
+        return id;
+    }
+
+    bool messages;
+    uint32_t blockRecords;
+    vector<string> levels;                      ///< Level dictionary in index order
+    unordered_map<string, uint8_t> levelIds;    ///< Level name -> dictionary index
+    vector<Row> rows;                           ///< Records in arrival order
+    string messageBlob;                         ///< Message bytes referenced by rows
+};
+
+/**
+ * Column pointers of one block, valid while the underlying image is.
+ * Varint columns (timestamp, user) must be decoded front to back.
+ */
+struct BinBlock {
+    BlockInfo      info;
+    const uint8_t* timestampBegin;
+    const uint8_t* timestampEnd;
+    const uint8_t* levels;
+    const uint8_t* userBegin;
+    const uint8_t* userEnd;
+    const uint8_t* ips;
+    const uint8_t* messageIndex;   ///< nullptr without messages
+    const uint8_t* messageBlob;
+    uint64_t       messageBlobSize;
+
+    uint32_t ip(uint32_t row) const {
+        uint32_t v;
+        memcpy(&v, ips + row * sizeof(uint32_t), sizeof(v));
+        return v;
+    }
+
+    string_view message(uint32_t row) const {
+        if (!messageIndex) return {};
+        uint64_t b, e;
+        memcpy(&b, messageIndex + row * sizeof(uint64_t), sizeof(b));
+        memcpy(&e, messageIndex + (row + 1) * sizeof(uint64_t), sizeof(e));
+        if (b > e || e > messageBlobSize) return {};
+        return string_view(reinterpret_cast<const char*>(messageBlob + b), e - b);
+    }
+
+    // Decodes all timestamps of the block into out
+    void decodeTimestamps(vector<int64_t>& out) const {
+        out.resize(info.recordCount);
+        const uint8_t* p = timestampBegin;
+        int64_t ts = info.minTimestamp;
+        for (uint32_t i = 0; i < info.recordCount; ++i) {
+            ts += zigzagDecode(getVarint(p, timestampEnd));
+            out[i] = ts;
+        }
+    }
+
+    // Decodes all user ids of the block into out
+    void decodeUsers(vector<uint32_t>& out) const {
+        out.resize(info.recordCount);
+        const uint8_t* p = userBegin;
+        for (uint32_t i = 0; i < info.recordCount; ++i) {
+            out[i] = static_cast<uint32_t>(getVarint(p, userEnd));
+        }
+    }
+};
+
+/**
+ * BinView validates a PLOGBIN image in memory and exposes its blocks
+ * without copying. The underlying bytes must outlive the view.
+ * Only the header and level dictionary are read on open; a block's zone map
+ * and data are touched only when that block is actually visited.
+ */
+class BinView {
+public:
+    /**
+     * Validates the header and level dictionary.
+     * @return false (with error() describing why) if the image is not usable.
+     */
+    bool open(const char* data, size_t size) {
+        base = reinterpret_cast<const uint8_t*>(data);
+        ok   = false;
+        if (!hasBinMagic(data, size) || size < sizeof(BinHeader)) return fail("bad magic");
+        memcpy(&hdr, data, sizeof(hdr));
+        if (hdr.version < BIN_MIN_VERSION || hdr.version > BIN_VERSION) {
+            return fail("unsupported version (re-run converter_app)");
+        }
+        if (hdr.fileSize > size)          return fail("truncated file");
+        if (hdr.levelDictOffset >= hdr.fileSize ||
+            !fits(hdr.blockIndexOffset, static_cast<uint64_t>(hdr.blockCount) * sizeof(BlockInfo), hdr.fileSize)) {
+            return fail("offsets out of range");
+        }
+        // Every record takes at least one byte of each column, and the block
+        // count must be the one the record count implies
+        if (hdr.blockRecords == 0 || hdr.recordCount > hdr.fileSize ||
+            hdr.blockCount != hdr.recordCount / hdr.blockRecords + (hdr.recordCount % hdr.blockRecords != 0)) {
+            return fail("inconsistent record counts");
+        }
+
+        // Level dictionary
+        levelNames.clear();
+        const uint8_t* p   = base + hdr.levelDictOffset;
+        const uint8_t* end = base + hdr.fileSize;
+        unsigned levelCount = *p++;
+        for (unsigned i = 0; i < levelCount; ++i) {
+            if (p >= end || p + 1 + *p > end) return fail("corrupt level dictionary");
+            unsigned l = *p++;
+            levelNames.emplace_back(reinterpret_cast<const char*>(p), l);
+            p += l;
+        }
+        ok = true;
+        return true;
+    }
+
+    bool valid() const { return ok; }
+    const string& error() const { return err; }
+    uint64_t recordCount() const { return hdr.recordCount; }
+    uint32_t blockCount() const { return hdr.blockCount; }
+    uint32_t blockRecords() const { return hdr.blockRecords; }
+    bool hasMessages() const { return hdr.flags & BIN_FLAG_MESSAGES; }
+    bool hasBlockChecksums() const { return hdr.version >= 3; }
+
+    const vector<string_view>& levels() const { return levelNames; }
+    string_view levelName(uint8_t idx) const {
+        return idx < levelNames.size() ? levelNames[idx] : string_view();
+    }
+
+    // Dictionary index of a level name, or -1 if the level never occurs
+    int levelIndex(string_view name) const {
+        for (size_t i = 0; i < levelNames.size(); ++i) {
+            if (levelNames[i] == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // Zone map of block i (read from the block index on demand)
+    BlockInfo block(uint32_t i) const {
+        BlockInfo b;
+        memcpy(&b, base + hdr.blockIndexOffset + static_cast<uint64_t>(i) * sizeof(BlockInfo), sizeof(b));
+        return b;
+    }
+
+    /**
+     * Resolves column pointers for a block returned by block().
+     * @return false if the block's offsets do not fit inside the data area.
+     */
+    bool columns(const BlockInfo& b, BinBlock& c) const {
+        const bool messages = hasMessages();
+        if (b.recordCount > hdr.blockRecords ||
+            b.timestampOffset > b.levelOffset ||
+            !fits(b.levelOffset, b.recordCount, b.userOffset) ||
+            b.userOffset > b.ipOffset ||
+            !fits(b.ipOffset, static_cast<uint64_t>(b.recordCount) * sizeof(uint32_t), b.endOffset) ||
+            (messages && (!fits(b.messageIndexOffset, (b.recordCount + 1ULL) * sizeof(uint64_t), b.messageBlobOffset) ||
+                          b.messageBlobOffset > b.endOffset)) ||
+            b.endOffset > hdr.blockIndexOffset) {
+            return false;
+        }
+        c.info            = b;
+        c.timestampBegin  = base + b.timestampOffset;
+        c.timestampEnd    = base + b.levelOffset;
+        c.levels          = base + b.levelOffset;
+        c.userBegin       = base + b.userOffset;
+        c.userEnd         = base + b.ipOffset;
+        c.ips             = base + b.ipOffset;
+        c.messageIndex    = messages ? base + b.messageIndexOffset : nullptr;
+        c.messageBlob     = messages ? base + b.messageBlobOffset : nullptr;
+        c.messageBlobSize = messages ? b.endOffset - b.messageBlobOffset : 0;
+        return true;
+    }
+
+    /**
+     * Checks a block against its stored checksum (always true for version 2
+     * files). Only call it for a block columns() accepted.
+     */
+    bool checkBlock(const BlockInfo& b) const {
+        return !hasBlockChecksums() || blockChecksum(b, base) == b.checksum;
+    }
+
+private:
+    // [off, off + n) lies within [0, limit), written so that nothing can wrap
+    static bool fits(uint64_t off, uint64_t n, uint64_t limit) {
+        return off <= limit && n <= limit - off;
+    }
+
+    bool fail(const char* why) {
+        err = why;
+        return false;
+    }
+
+    const uint8_t* base = nullptr;
+    BinHeader hdr{};
+    vector<string_view> levelNames;  ///< Views into the dictionary section
+    bool ok = false;
+    string err;
+};
+
+#endif // BIN_FORMAT_HPP
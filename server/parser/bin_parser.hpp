@@ -0,0 +1,310 @@
+// File: server/parser/bin_parser.hpp
+// BINParser: Reads pre-converted PLOGBIN columnar logs and computes statistics based on AnalysisType.
+
+#ifndef BIN_PARSER_HPP
+#define BIN_PARSER_HPP
+
+#include "log_parser.hpp"
+#include "bin_format.hpp"
+#include "mapped_file.hpp"
+#include "../util/async_logger.hpp"
+#include "../util/roaring_bitmap.hpp"
+#include <atomic>
+#include <climits>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * BINParser implements LogParser over the columnar PLOGBIN format produced by
+ * converter_app. Only the columns needed for the requested analysis are read,
+ * grouping is done on integer keys, so no per-record strings are built, and
+ * blocks outside the date range are pruned using their zone maps.
+ *
+ * Unlike the text parsers, date-range filtering is applied here (setDateRange)
+ * because the server cannot filter a binary payload textually.
+ */
+class BINParser : public LogParser {
+public:
+    /**
+     * Constructor
+     * @param rawBin Complete PLOGBIN image held in memory (e.g. received over the network).
+     */
+    explicit BINParser(const string& rawBin)
+        : dataStr(rawBin) {
+        view.open(dataStr.data(), dataStr.size());
+    }
+
+    /**
+     * Constructor over an image owned elsewhere (e.g. a dataset stored on the server).
+     * @param data  Start of the PLOGBIN image.
+     * @param size  Image length in bytes.
+     * @param owner Keeps the bytes alive for the lifetime of the parser.
+     */
+    BINParser(const char* data, size_t size, shared_ptr<const void> owner)
+        : keepAlive(move(owner)) {
+        view.open(data, size);
+    }
+
+    /**
+     * Memory-maps a PLOGBIN file from disk.
+     * @param path File produced by converter_app.
+     * @return Parser owning the mapping, or nullptr if the file cannot be mapped.
+     */
+    static unique_ptr<BINParser> openFile(const string& path) {
+        MappedFile file;
+        if (!file.open(path)) return nullptr;
+        file.adviseSequential();
+        return unique_ptr<BINParser>(new BINParser(move(file)));
+    }
+
+    bool valid() const { return view.valid(); }
+    bool hasMessages() const { return view.hasMessages(); }
+
+    /**
+     * Restricts parse/forEachRecord to records whose date lies in [fromDate, toDate].
+     * Empty strings leave that side open; both use the server's YYYY-MM-DD format.
+     */
+    void setDateRange(const string& fromDate, const string& toDate) {
+        int64_t t;
+        fromTs = (!fromDate.empty() && parseTimestamp(fromDate, t)) ? t : INT64_MIN;
+        toTs   = (!toDate.empty()   && parseTimestamp(toDate, t))   ? t + 86399 : INT64_MAX;
+    }
+
+    /**
+     * Restricts parse/forEachRecord to the given record positions (e.g. from a
+     * BitmapIndex). Blocks without any selected position are never read.
+     * @param sel Positions to keep, or nullptr for all; must outlive the parser calls.
+     */
+    void setSelection(const RoaringBitmap* sel) { selection = sel; }
+
+    /**
+     * Verifies each block's checksum the first time it is read. A block that
+     * fails is skipped and counted in corruptBlocks().
+     * @param states One entry per block (0 = unchecked, 1 = intact, 2 = corrupt),
+     *               shared by every parser over the same image so each block
+     *               is hashed once; nullptr disables the check.
+     */
+    void setBlockChecks(atomic<uint8_t>* states) { blockStates = states; }
+
+    /**
+     * Aggregates counts over the requested column.
+     * Blocks whose zone map lies entirely outside the date range are skipped
+     * without touching their data; blocks entirely inside it skip the
+     * timestamp column as well.
+     *
+     * @param type Dimension for analysis: BY_USER, BY_IP, or BY_LOG_LEVEL.
+     * @return unordered_map where key=entity (user ID, IP, or log level), value=count.
+     */
+    unordered_map<string, int> parse(AnalysisType type) override {
+        unordered_map<string, int> result;
+        if (!view.valid()) {
+            LOG_EVERY(ERROR, 10) << "Binary log parsing failed: " << view.error();
+            return result;
+        }
+
+        int levelCounts[256] = {0};
+        unordered_map<uint32_t, int> counts;
+        forEachSelectedBlock([&](const BinBlock& blk, const vector<uint32_t>& rows) {
+            switch (type) {
+                case AnalysisType::BY_USER:
+                    blk.decodeUsers(users);
+                    for (uint32_t r : rows) ++counts[users[r]];
+                    break;
+                case AnalysisType::BY_IP:
+                    for (uint32_t r : rows) ++counts[blk.ip(r)];
+                    break;
+                case AnalysisType::BY_LOG_LEVEL:
+                default:
+                    for (uint32_t r : rows) ++levelCounts[blk.levels[r]];
+                    break;
+            }
+        });
+
+        switch (type) {
+            case AnalysisType::BY_USER:
+                for (const auto& kv : counts) result[to_string(kv.first)] = kv.second;
+                break;
+            case AnalysisType::BY_IP:
+                for (const auto& kv : counts) result[formatIPv4(kv.first)] = kv.second;
+                break;
+            case AnalysisType::BY_LOG_LEVEL:
+            default:
+                for (unsigned i = 0; i < 256; ++i) {
+                    string_view name = view.levelName(static_cast<uint8_t>(i));
+                    if (levelCounts[i] > 0 && !name.empty()) result[string(name)] = levelCounts[i];
+                }
+                break;
+        }
+        return result;
+    }
+
+    /**
+     * Decodes every record (within the date range, if set) into a LogRecord,
+     * in timestamp order.
+     *
+     * @param visit Callback invoked once per record.
+     */
+    void forEachRecord(const RecordVisitor& visit) override {
+        if (!view.valid()) {
+            LOG_EVERY(ERROR, 10) << "Binary log parsing failed: " << view.error();
+            return;
+        }
+        LogRecord rec;
+        forEachSelectedBlock([&](const BinBlock& blk, const vector<uint32_t>& rows) {
+            blk.decodeTimestamps(timestamps);
+            blk.decodeUsers(users);
+            for (uint32_t r : rows) {
+                rec.timestamp = timestamps[r];
+                rec.userId    = users[r];
+                rec.level     = view.levelName(blk.levels[r]);
+                rec.ip        = blk.ip(r);
+                rec.message   = blk.message(r);
+                if (accept(rec)) visit(rec);
+            }
+        }, filter);
+    }
+
+    bool hasFieldText() const override { return false; }
+
+    // Blocks read / pruned by the zone maps during the last parse or forEachRecord
+    uint64_t blocksScanned() const { return scanned; }
+    uint64_t blocksSkipped() const { return skipped; }
+    // Blocks that failed their checksum during the last parse or forEachRecord
+    uint64_t corruptBlocks() const { return corrupt; }
+
+private:
+    explicit BINParser(MappedFile file)
+        : mapped(move(file)) {
+        view.open(mapped.data(), mapped.size());
+    }
+
+    /**
+     * Calls fn(block, rows) for every block that can contain selected records,
+     * where rows lists the matching row numbers of that block. Without a
+     * selection every block is a candidate; with one, only blocks holding at
+     * least one selected position are visited. A selection from the bitmap
+     * index (QUERY LEVEL:/USER:) is exact per record, so the zone maps could
+     * not prune any block it leaves; where is checked against them instead.
+     *
+     * @param where Filter whose mayMatch() may rule out whole blocks, or nullptr.
+     */
+    template <typename Fn>
+    void forEachSelectedBlock(Fn&& fn, const RecordFilter* where = nullptr) {
+        scanned = 0;
+        corrupt = 0;
+        pruneBy = where;
+        if (!selection) {
+            // Every row is a candidate; visitBlock clips to the block's length
+            candidates.clear();
+            uint64_t perBlock = min<uint64_t>(view.blockRecords(), view.recordCount());
+            for (uint32_t r = 0; r < perBlock; ++r) candidates.push_back(r);
+            for (uint32_t b = 0; b < view.blockCount(); ++b) visitBlock(b, fn);
+        } else if (view.blockRecords() > 0) {
+            // Selected positions arrive in ascending order, i.e. block by block
+            const uint32_t per = view.blockRecords();
+            uint32_t current = UINT32_MAX;
+            candidates.clear();
+            selection->forEach([&](uint32_t pos) {
+                uint32_t b = pos / per;
+                if (b != current) {
+                    if (!candidates.empty()) visitBlock(current, fn);
+                    candidates.clear();
+                    current = b;
+                }
+                candidates.push_back(pos - b * per);
+            });
+            if (!candidates.empty()) visitBlock(current, fn);
+        }
+        skipped = view.blockCount() - scanned;
+    }
+
+    // Applies the date range to candidates of block b and hands the survivors to fn
+    template <typename Fn>
+    void visitBlock(uint32_t b, Fn&& fn) {
+        if (b >= view.blockCount()) return;
+        BlockInfo info = view.block(b);
+        if (info.maxTimestamp < fromTs || info.minTimestamp > toTs) return;
+        if (pruneBy && !pruneBy->mayMatch(zoneOf(info))) return;
+        BinBlock blk;
+        if (!view.columns(info, blk)) {
+            LOG_EVERY(ERROR, 10) << "Corrupt block " << b << " in binary log, skipped";
+            return;
+        }
+        ++scanned;
+        if (blockStates && !blockIntact(b, info)) {
+            ++corrupt;
+            LOG_EVERY(ERROR, 10) << "Block " << b << " in binary log failed checksum verification, skipped";
+            return;
+        }
+
+        rows.clear();
+        if (info.minTimestamp >= fromTs && info.maxTimestamp <= toTs) {
+            // Whole block is inside the range
+            for (uint32_t r : candidates) {
+                if (r < info.recordCount) rows.push_back(r);
+            }
+        } else {
+            blk.decodeTimestamps(timestamps);
+            for (uint32_t r : candidates) {
+                if (r < info.recordCount && timestamps[r] >= fromTs && timestamps[r] <= toTs) {
+                    rows.push_back(r);
+                }
+            }
+        }
+        if (!rows.empty()) fn(blk, rows);
+    }
+
+    // The block's zone map in the form RecordFilter::mayMatch takes
+    const RecordZone& zoneOf(const BlockInfo& info) {
+        zone.minTimestamp = info.minTimestamp;
+        zone.maxTimestamp = info.maxTimestamp;
+        zone.minUser      = info.minUser;
+        zone.maxUser      = info.maxUser;
+        zone.minIp        = info.minIp;
+        zone.maxIp        = info.maxIp;
+        zone.levels.clear();
+        const auto& names = view.levels();
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (info.hasLevel(static_cast<uint8_t>(i))) zone.levels.push_back(names[i]);
+        }
+        return zone;
+    }
+
+    // First reader of block b hashes it; concurrent first readers may both do so, harmlessly
+    bool blockIntact(uint32_t b, const BlockInfo& info) {
+        uint8_t state = blockStates[b].load(memory_order_relaxed);
+        if (state == 0) {
+            state = view.checkBlock(info) ? 1 : 2;
+            blockStates[b].store(state, memory_order_relaxed);
+        }
+        return state == 1;
+    }
+
+    string dataStr;        ///< In-memory image (network payloads)
+    MappedFile mapped;     ///< Mapped image (files opened with openFile)
+    shared_ptr<const void> keepAlive;  ///< Owner of an externally held image
+    BinView view;          ///< Column accessors over whichever source is in use
+    int64_t fromTs = INT64_MIN;
+    int64_t toTs   = INT64_MAX;
+    uint64_t scanned = 0;  ///< Blocks read by the last scan
+    uint64_t skipped = 0;  ///< Blocks pruned by the last scan
+    uint64_t corrupt = 0;  ///< Blocks that failed their checksum in the last scan
+    atomic<uint8_t>* blockStates = nullptr;  ///< Optional per-block checksum state
+
+    const RoaringBitmap* selection = nullptr;  ///< Optional record positions to restrict to
+    const RecordFilter*  pruneBy   = nullptr;  ///< Filter checked against zone maps this scan
+    RecordZone zone;                           ///< Scratch for zoneOf()
+
+    // Per-block scratch buffers reused across blocks
+    vector<uint32_t> candidates;
+    vector<uint32_t> rows;
+    vector<int64_t>  timestamps;
+    vector<uint32_t> users;
+};
+
+#endif // BIN_PARSER_HPP
@@ -0,0 +1,122 @@
+// File: server/parser/date_filter.hpp
+// Format detection and FROM/TO date filtering of raw JSON, TXT and XML payloads.
+
+#ifndef DATE_FILTER_HPP
+#define DATE_FILTER_HPP
+
+#include "bin_format.hpp"
+#include "lib/nlohmann/json.hpp"
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// Enumeration of supported log formats
+enum class FileType { JSON, XML, TXT, BIN };
+
+// Detect file type based on the PLOGBIN magic or the first non-whitespace character
+inline FileType detectFileType(const string& body) {
+    if (hasBinMagic(body.data(), body.size())) return FileType::BIN;
+    auto p = body.find_first_not_of(" \t\r\n");
+    if (p == string::npos) return FileType::TXT;
+    char c = body[p];
+    if (c == '[' || c == '{') return FileType::JSON;
+    if (c == '<')            return FileType::XML;
+    return FileType::TXT;
+}
+
+// Filter JSON logs by date range (YYYY-MM-DD)
+inline string filterJsonByDate(const string& jsonBody,
+                             const string& fromDate,
+                             const string& toDate) {
+    nlohmann::json arr;
+    try {
+        istringstream iss(jsonBody);
+        iss >> arr;
+    } catch (...) {
+         // Return original if parsing fails
+        return jsonBody; 
+    }
+    nlohmann::json filtered = nlohmann::json::array();
+    for (auto& entry : arr) {
+        if (!entry.is_object()) continue;  // the parsers skip these as well
+        auto it = entry.find("timestamp");
+        string ts = it != entry.end() && it->is_string() ? it->get<string>() : string();
+        if (ts.size() >= 10) {
+            string date = ts.substr(0, 10);
+            if ((!fromDate.empty() && date < fromDate) ||
+                (!toDate.empty()   && date > toDate)) {
+                continue;
+            }
+        }
+        filtered.push_back(entry);
+    }
+    return filtered.dump();
+}
+
+// Filter TXT lines by date range ("YYYY-MM-DD")
+inline string filterTxtByDate(const string& txtBody,
+                            const string& fromDate,
+                            const string& toDate) {
+    istringstream iss(txtBody);
+    ostringstream oss;
+    string line;
+    while (getline(iss, line)) {
+        if (line.size() < 10) continue;
+        string date = line.substr(0, 10);
+        if ((!fromDate.empty() && date < fromDate) ||
+            (!toDate.empty()   && date > toDate)) {
+            continue;
+        }
+        oss << line << "\n";
+    }
+    return oss.str();
+}
+
+// Filter XML payload by date range ("YYYY-MM-DD")
+inline string filterXmlByDate(const string& xmlBody,
+                                   const string& fromDate,
+                                   const string& toDate) {
+    auto getTagValue = [&](const string& s, const string& tag) -> string {
+        string open  = "<"  + tag + ">";
+        string close = "</" + tag + ">";
+        size_t p1 = s.find(open);
+        if (p1 == string::npos) return "";
+        p1 += open.size();
+        size_t p2 = s.find(close, p1);
+        if (p2 == string::npos) return "";
+        return s.substr(p1, p2 - p1);
+    };
+
+    string filtered = "<logs>";
+    size_t pos = 0;
+    while (true) {
+        // find the next <log>...</log> block
+        size_t start = xmlBody.find("<log>", pos);
+        if (start == string::npos) break;
+        size_t end = xmlBody.find("</log>", start);
+        if (end == string::npos) break;
+        // include the closing tag
+        size_t blockEnd = end + strlen("</log>");
+        string logBlock = xmlBody.substr(start, blockEnd - start);
+
+        // extract timestamp and its date prefix
+        string ts = getTagValue(logBlock, "timestamp");
+        string date = ts.size() >= 10 ? ts.substr(0, 10) : "";
+
+        // apply filters
+        bool keep = true;
+        if (!fromDate.empty() && date < fromDate) keep = false;
+        if (!toDate.empty()   && date > toDate)   keep = false;
+
+        if (keep) {
+            filtered += logBlock;
+        }
+        pos = blockEnd;
+    }
+    filtered += "</logs>";
+    return filtered;
+}
+
+#endif // DATE_FILTER_HPP
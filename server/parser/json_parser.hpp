@@ -5,6 +5,7 @@
 #define JSON_PARSER_HPP
 
 #include "log_parser.hpp"
+#include "../util/async_logger.hpp"
 #include <sstream>
 #include <iostream>
 #include <unordered_map>
@@ -41,25 +42,27 @@ public:
             istringstream iss(dataStr);
             iss >> j;
         } catch (const exception& e) {
-            cerr << "[ERROR] JSON parsing failed: " << e.what() << "\n";
+            LOG_EVERY(ERROR, 10) << "JSON parsing failed: " << e.what();
             return {};
         }
 
-        // 2) Iterate through each element in the JSON array
+        // 2) Iterate through each element in the JSON array; entries that are
+        //    not objects or lack the field with a usable type are skipped
         for (const auto& entry : j) {
+            if (!entry.is_object()) continue;
             string key;
             // 3) Select grouping key based on AnalysisType
             switch (type) {
                 case AnalysisType::BY_USER:
-                    // Convert numeric user_id to string
-                    key = to_string(entry["user_id"].get<int>());
+                    // Numeric user_id rendered as a string
+                    key = userField(entry);
                     break;
                 case AnalysisType::BY_IP:
-                    key = entry["ip_address"].get<string>();
+                    key = stringField(entry, "ip_address");
                     break;
                 case AnalysisType::BY_LOG_LEVEL:
                 default:
-                    key = entry["log_level"].get<string>();
+                    key = stringField(entry, "log_level");
                     break;
             }
             // 4) Increment count for this key
@@ -70,7 +73,53 @@ public:
         return result;
     }
 
+    /**
+     * Visits each JSON log object as a LogRecord; fields that do not convert
+     * are flagged as makeRecord() describes. Non-object entries are skipped.
+     *
+     * @param visit Callback invoked once per record.
+     */
+    void forEachRecord(const RecordVisitor& visit) override {
+        nlohmann::json j;
+        try {
+            istringstream iss(dataStr);
+            iss >> j;
+        } catch (const exception& e) {
+            LOG_EVERY(ERROR, 10) << "JSON parsing failed: " << e.what();
+            return;
+        }
+
+        // The record's views point into these for the duration of the visit
+        string ts, level, message, user, ip;
+        for (const auto& entry : j) {
+            if (!entry.is_object()) continue;
+            ts      = stringField(entry, "timestamp");
+            level   = stringField(entry, "log_level");
+            message = stringField(entry, "message");
+            user    = userField(entry);
+            ip      = stringField(entry, "ip_address");
+            LogRecord rec;
+            makeRecord(ts, level, message, user, ip, rec);
+            if (accept(rec)) visit(rec);
+        }
+    }
+
 private:
+    // String member of an entry, or "" if it is missing or not a string
+    static string stringField(const nlohmann::json& entry, const char* name) {
+        auto it = entry.find(name);
+        return it != entry.end() && it->is_string() ? it->get<string>() : string();
+    }
+
+    // user_id of an entry as text: a number in decimal, a string as is, else ""
+    static string userField(const nlohmann::json& entry) {
+        auto it = entry.find("user_id");
+        if (it == entry.end()) return string();
+        if (it->is_number_unsigned()) return to_string(it->get<uint64_t>());
+        if (it->is_number())          return to_string(it->get<int64_t>());
+        return it->is_string() ? it->get<string>() : string();
+    }
+
     string dataStr;  ///< Raw JSON payload stored in-memory
 };
 
@@ -3,6 +3,8 @@
 
 #include <unordered_map>
 #include <string>
+#include "log_record.hpp"
+#include "record_filter.hpp"
 
 enum class AnalysisType {
     BY_USER,
@@ -18,6 +20,23 @@ public:
 
     // Parse the log file and return the analysis result
     virtual unordered_map<string, int> parse(AnalysisType type) = 0;
+
+    // Visit every record parse() would count, in file order
+    virtual void forEachRecord(const RecordVisitor& visit) = 0;
+
+    // False if records carry only the converted user id and IP, not the
+    // text they were written as (BIN stores no text)
+    virtual bool hasFieldText() const { return true; }
+
+    // Restrict forEachRecord to records accepted by filter (nullptr = all);
+    // the filter must outlive the parser calls
+    void setFilter(const RecordFilter* f) { filter = f; }
+
+protected:
+    // Checked by each parser's record loop before the visitor is called
+    bool accept(const LogRecord& rec) const { return !filter || filter->matches(rec); }
+
+    const RecordFilter* filter = nullptr;
 };
 
 #endif // LOG_PARSER_HPP
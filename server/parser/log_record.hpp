@@ -0,0 +1,191 @@
+// File: server/parser/log_record.hpp
+// LogRecord: Format-independent view of a single parsed log entry, plus the
+// helpers used to convert textual fields into their compact integer forms.
+
+#ifndef LOG_RECORD_HPP
+#define LOG_RECORD_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+/**
+ * One log entry as produced by LogParser::forEachRecord.
+ * String fields are views that are only valid for the duration of the visitor call.
+ * A field that did not convert (e.g. "UserID: alice", an IPv6 address) is left
+ * 0 and its bit is cleared in valid; consumers skip records lacking a field they need.
+ */
+struct LogRecord {
+    // Bits of valid
+    enum Field : uint8_t { TIMESTAMP = 1, USER = 2, IP = 4, ALL = 7 };
+
+    int64_t     timestamp = 0;  ///< Seconds since 1970-01-01 00:00:00 (the log's own clock, no TZ)
+    string_view level;          ///< e.g. "INFO"
+    string_view message;        ///< Free-text message (may be empty)
+    uint32_t    userId    = 0;  ///< Numeric user id
+    uint32_t    ip        = 0;  ///< IPv4 address in host byte order (0 if not a valid IPv4)
+    string_view userText;       ///< User id as written (text formats only)
+    string_view ipText;         ///< IP address as written (text formats only)
+    uint8_t     valid     = ALL;  ///< Field bits that converted
+
+    bool has(uint8_t fields) const { return (valid & fields) == fields; }
+};
+
+// Callback invoked once per record
+using RecordVisitor = function<void(const LogRecord&)>;
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm)
+inline int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+/**
+ * Parses "YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS" into seconds since epoch.
+ * @return false if the text does not have that shape.
+ */
+inline bool parseTimestamp(string_view s, int64_t& out) {
+    auto digits = [&](size_t pos, size_t len, unsigned& v) {
+        v = 0;
+        for (size_t i = pos; i < pos + len; ++i) {
+            if (s[i] < '0' || s[i] > '9') return false;
+            v = v * 10 + static_cast<unsigned>(s[i] - '0');
+        }
+        return true;
+    };
+    unsigned y, mo, d, h = 0, mi = 0, sec = 0;
+    if (s.size() < 10 || s[4] != '-' || s[7] != '-') return false;
+    if (!digits(0, 4, y) || !digits(5, 2, mo) || !digits(8, 2, d)) return false;
+    if (mo < 1 || mo > 12 || d < 1 || d > 31) return false;
+    if (s.size() >= 19) {
+        if (s[13] != ':' || s[16] != ':') return false;
+        if (!digits(11, 2, h) || !digits(14, 2, mi) || !digits(17, 2, sec)) return false;
+    }
+    out = daysFromCivil(y, mo, d) * 86400 + h * 3600 + mi * 60 + sec;
+    return true;
+}
+
+// Formats seconds since epoch back into "YYYY-MM-DD HH:MM:SS"
+inline string formatTimestamp(int64_t t) {
+    int64_t days = t >= 0 ? t / 86400 : (t - 86399) / 86400;
+    int64_t secs = t - days * 86400;
+    // civil_from_days
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp  = (5 * doy + 2) / 153;
+    const unsigned d   = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m   = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t  y   = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+
+    char buf[80];  // worst case for the types below, so -Wformat-truncation can prove it fits
+    snprintf(buf, sizeof(buf), "%04lld-%02u-%02u %02u:%02u:%02u",
+             static_cast<long long>(y), m, d,
+             static_cast<unsigned>(secs / 3600),
+             static_cast<unsigned>(secs / 60 % 60),
+             static_cast<unsigned>(secs % 60));
+    return buf;
+}
+
+// Netmask of a /bits prefix in host byte order (0 for /0)
+inline uint32_t prefixMask(int bits) {
+    return bits <= 0 ? 0 : ~uint32_t(0) << (32 - bits);
+}
+
+/**
+ * Parses a dotted-quad IPv4 address ("10.0.0.1") into host byte order.
+ * @return false if the text is not a valid IPv4 address.
+ */
+inline bool parseIPv4(string_view s, uint32_t& out) {
+    uint32_t addr = 0;
+    unsigned octet = 0, octets = 0, digits = 0;
+    for (char c : s) {
+        if (c >= '0' && c <= '9') {
+            octet = octet * 10 + static_cast<unsigned>(c - '0');
+            if (++digits > 3 || octet > 255) return false;
+        } else if (c == '.') {
+            if (digits == 0 || ++octets > 3) return false;
+            addr = (addr << 8) | octet;
+            octet = digits = 0;
+        } else {
+            return false;
+        }
+    }
+    if (digits == 0 || octets != 3) return false;
+    out = (addr << 8) | octet;
+    return true;
+}
+
+/**
+ * Parses "10.0.0.0/8" (or a bare address, taken as /32) into a network and
+ * prefix length. Host bits below the prefix are cleared.
+ * @return false if the address or the prefix length is invalid.
+ */
+inline bool parseCIDR(string_view s, uint32_t& network, int& bits) {
+    size_t slash = s.find('/');
+    uint32_t addr;
+    if (!parseIPv4(s.substr(0, slash), addr)) return false;
+    bits = 32;
+    if (slash != string_view::npos) {
+        string_view digits = s.substr(slash + 1);
+        if (digits.empty() || digits.size() > 2) return false;
+        bits = 0;
+        for (char c : digits) {
+            if (c < '0' || c > '9') return false;
+            bits = bits * 10 + (c - '0');
+        }
+        if (bits > 32) return false;
+    }
+    network = addr & prefixMask(bits);
+    return true;
+}
+
+// Formats a host-byte-order IPv4 address as a dotted quad
+inline string formatIPv4(uint32_t ip) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u",
+             ip >> 24, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF);
+    return buf;
+}
+
+// Parses an unsigned decimal user id; returns false on any non-digit
+inline bool parseUserId(string_view s, uint32_t& out) {
+    if (s.empty() || s.size() > 10) return false;
+    uint64_t v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<uint64_t>(c - '0');
+    }
+    if (v > UINT32_MAX) return false;
+    out = static_cast<uint32_t>(v);
+    return true;
+}
+
+/**
+ * Builds a LogRecord from the text fields of one entry. Every entry is kept;
+ * the timestamp, user id and IPv4 address are converted where they can be
+ * and rec.valid records which of them did.
+ */
+inline void makeRecord(string_view timestamp, string_view level, string_view message,
+                       string_view user, string_view ip, LogRecord& rec) {
+    rec.valid    = 0;
+    rec.level    = level;
+    rec.message  = message;
+    rec.userText = user;
+    rec.ipText   = ip;
+    if (parseTimestamp(timestamp, rec.timestamp)) rec.valid |= LogRecord::TIMESTAMP;
+    if (parseUserId(user, rec.userId))            rec.valid |= LogRecord::USER;
+    if (parseIPv4(ip, rec.ip))                    rec.valid |= LogRecord::IP;
+}
+
+#endif // LOG_RECORD_HPP
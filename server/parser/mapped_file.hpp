@@ -0,0 +1,86 @@
+// File: server/parser/mapped_file.hpp
+// MappedFile: RAII wrapper around a read-only mmap of a whole file.
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * Maps a file read-only into memory. Pages are faulted in lazily by the kernel,
+ * so opening a large file is cheap; only the bytes actually read are paged in.
+ * Move-only; the mapping is released in the destructor.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : ptr(other.ptr), len(other.len) {
+        other.ptr = nullptr;
+        other.len = 0;
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            release();
+            ptr = other.ptr;
+            len = other.len;
+            other.ptr = nullptr;
+            other.len = 0;
+        }
+        return *this;
+    }
+
+    ~MappedFile() { release(); }
+
+    /**
+     * Maps the file at path.
+     * @return false if the file cannot be opened or mapped (empty files are rejected).
+     */
+    bool open(const string& path) {
+        release();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // the mapping keeps its own reference to the file
+        if (p == MAP_FAILED) return false;
+        ptr = static_cast<const char*>(p);
+        len = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    // Hint the kernel that the whole mapping will be read front to back
+    void adviseSequential() const {
+        if (ptr) madvise(const_cast<char*>(ptr), len, MADV_SEQUENTIAL);
+    }
+
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool isOpen() const { return ptr != nullptr; }
+
+private:
+    void release() {
+        if (ptr) munmap(const_cast<char*>(ptr), len);
+        ptr = nullptr;
+        len = 0;
+    }
+
+    const char* ptr = nullptr;  ///< Start of the mapping
+    size_t len = 0;             ///< Mapping length in bytes
+};
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,616 @@
+// File: server/parser/record_filter.hpp
+// RecordFilter: Compiles WHERE expressions into a predicate over LogRecord fields.
+
+#ifndef RECORD_FILTER_HPP
+#define RECORD_FILTER_HPP
+
+#include "log_record.hpp"
+#include "../util/aho_corasick.hpp"
+#include "../util/regex_dfa.hpp"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Bounds on a group of records, e.g. a PLOGBIN block's zone map: every record
+ * lies inside the ranges and has one of the listed levels.
+ */
+struct RecordZone {
+    int64_t  minTimestamp = 0, maxTimestamp = 0;
+    uint32_t minUser = 0, maxUser = 0;
+    uint32_t minIp = 0, maxIp = 0;
+    vector<string_view> levels;  ///< Levels that occur
+};
+
+/**
+ * Filter expressions, e.g.
+ *
+ *   level IN (ERROR,CRITICAL) AND ip IN 10.0.0.0/8 AND user != 0
+ *
+ * Grammar (keywords and field names are case-insensitive):
+ *   expr       := term (OR term)*
+ *   term       := factor (AND factor)*
+ *   factor     := NOT factor | '(' expr ')' | comparison
+ *   comparison := level (= | !=) NAME  |  level [NOT] IN (NAME, ...)
+ *               | user  (= | != | < | <= | > | >=) NUMBER  |  user [NOT] IN (NUMBER, ...)
+ *               | ip    (= | !=) ADDR[/BITS]  |  ip [NOT] IN ADDR/BITS | (ADDR[/BITS], ...)
+ *               | time  (= | != | < | <= | > | >=) 'YYYY-MM-DD[ HH:MM:SS]'   (a bare date is the whole day)
+ *               | message [NOT] CONTAINS 'literal' | ('literal', ...)
+ *               | message [NOT] MATCHES 'regex'
+ *
+ * The expression is compiled once into a small node array. Operands of every
+ * AND/OR are reordered cheapest first (integer compares, then set and prefix
+ * lookups, then level string compares, message scans last) so most records
+ * are decided by the cheap checks and short-circuit evaluation skips the rest.
+ */
+class RecordFilter {
+public:
+    /**
+     * Parses and compiles an expression.
+     * @param expr Filter text from the WHERE header.
+     * @param err  Set to a description of the first syntax error.
+     * @return false if expr is not a valid filter.
+     */
+    bool compile(const string& expr, string& err) {
+        nodes.clear();
+        tokens.clear();
+        pos = 0;
+        depth = 0;
+        error.clear();
+        if (!tokenize(expr)) {
+            err = error;
+            return false;
+        }
+        root = parseOr();
+        if (root >= 0 && pos < tokens.size()) fail("unexpected '" + tokens[pos].text + "'");
+        if (!error.empty()) {
+            err = error;
+            nodes.clear();
+            root = -1;
+            return false;
+        }
+        reorder(root);
+        return true;
+    }
+
+    /**
+     * ANDs "message contains any of patterns" onto the expression (used for
+     * the CONTAINS header).
+     * @return false if the patterns cannot be compiled.
+     */
+    bool addContains(const vector<string>& patterns, string& err) {
+        auto matcher = make_shared<AhoCorasick>();
+        if (!matcher->build(patterns)) {
+            err = "need 1 or more non-empty patterns, at most "
+                + to_string(AhoCorasick::MAX_PATTERN_BYTES) + " bytes in total";
+            return false;
+        }
+        Node n{Kind::MESSAGE_ANY};
+        n.matcher = matcher;
+        andWith(add(move(n)));
+        return true;
+    }
+
+    /**
+     * ANDs "message matches regex" onto the expression (used for the MATCH
+     * header).
+     * @return false if the pattern does not compile.
+     */
+    bool addMatch(const string& pattern, string& err) {
+        auto regex = make_shared<RegexDFA>();
+        if (!regex->compile(pattern, err)) return false;
+        Node n{Kind::MESSAGE_MATCH};
+        n.regex = regex;
+        andWith(add(move(n)));
+        return true;
+    }
+
+    bool empty() const { return root < 0; }
+
+    // True if any part of the expression looks at the message text
+    bool usesMessage() const {
+        for (const Node& n : nodes) {
+            if (n.kind == Kind::MESSAGE_ANY || n.kind == Kind::MESSAGE_MATCH) return true;
+        }
+        return false;
+    }
+
+    /**
+     * True if rec satisfies the compiled expression (an empty filter accepts
+     * everything). A comparison on a field the record could not convert (see
+     * LogRecord::valid) is false, and so is a NOT over one. MATCHES nodes grow their DFA cache as they go, so a filter
+     * holding one must only be used by one thread at a time.
+     */
+    bool matches(const LogRecord& rec) const { return root < 0 || eval(root, rec); }
+
+    /**
+     * False only if no record inside zone can satisfy the expression, so the
+     * whole group can be skipped. Conservative: true whenever unsure. Records
+     * are taken to have every field converted, as PLOGBIN records do.
+     */
+    bool mayMatch(const RecordZone& zone) const { return root < 0 || possible(root, zone, true); }
+
+private:
+    enum class Kind { AND, OR, NOT, LEVEL_IN, USER_CMP, USER_IN, IP_IN, TIME_CMP, MESSAGE_ANY,
+                      MESSAGE_MATCH };
+    enum class Op { EQ, NE, LT, LE, GT, GE };
+
+    struct Node {
+        Kind kind;
+        Op   op = Op::EQ;
+        bool negate = false;                  ///< For the *_IN kinds: NOT IN / !=
+        int64_t value = 0;                    ///< USER_CMP, TIME_CMP operand
+        vector<string>   levels;              ///< LEVEL_IN names
+        vector<uint32_t> users;               ///< USER_IN ids, sorted
+        vector<pair<uint32_t, uint32_t>> nets;  ///< IP_IN (network, mask)
+        vector<int> children;                 ///< AND, OR, NOT operands
+        uint8_t needs = 0;                    ///< LogRecord::Field bits read by this subtree
+        shared_ptr<const AhoCorasick> matcher;  ///< MESSAGE_ANY patterns
+        shared_ptr<RegexDFA> regex;             ///< MESSAGE_MATCH pattern (caches DFA states)
+    };
+
+    struct Token {
+        string text;
+        bool   quoted = false;
+    };
+
+    bool eval(int i, const LogRecord& rec) const {
+        const Node& n = nodes[i];
+        switch (n.kind) {
+            case Kind::AND:
+                for (int c : n.children) if (!eval(c, rec)) return false;
+                return true;
+            case Kind::OR:
+                for (int c : n.children) if (eval(c, rec)) return true;
+                return false;
+            case Kind::NOT:
+                return rec.has(n.needs) && !eval(n.children[0], rec);
+            case Kind::USER_CMP:
+                return rec.has(LogRecord::USER) && compare(rec.userId, n.op, n.value);
+            case Kind::TIME_CMP:
+                return rec.has(LogRecord::TIMESTAMP) && compare(rec.timestamp, n.op, n.value);
+            case Kind::MESSAGE_ANY:
+                return n.matcher->containsAny(rec.message) != n.negate;
+            case Kind::MESSAGE_MATCH:
+                return n.regex->search(rec.message) != n.negate;
+            case Kind::USER_IN:
+                return rec.has(LogRecord::USER) &&
+                       binary_search(n.users.begin(), n.users.end(), rec.userId) != n.negate;
+            case Kind::IP_IN: {
+                if (!rec.has(LogRecord::IP)) return false;
+                bool hit = false;
+                for (const auto& net : n.nets) {
+                    if ((rec.ip & net.second) == net.first) { hit = true; break; }
+                }
+                return hit != n.negate;
+            }
+            case Kind::LEVEL_IN:
+            default: {
+                bool hit = false;
+                for (const auto& name : n.levels) {
+                    if (rec.level == name) { hit = true; break; }
+                }
+                return hit != n.negate;
+            }
+        }
+    }
+
+    // Whether some record in zone can make node i evaluate to value
+    bool possible(int i, const RecordZone& z, bool value) const {
+        const Node& n = nodes[i];
+        switch (n.kind) {
+            case Kind::AND:
+            case Kind::OR:
+                // AND is true / OR is false only if every operand is
+                if ((n.kind == Kind::AND) == value) {
+                    for (int c : n.children) if (!possible(c, z, value)) return false;
+                    return true;
+                }
+                for (int c : n.children) if (possible(c, z, value)) return true;
+                return false;
+            case Kind::NOT:
+                return possible(n.children[0], z, !value);
+            case Kind::USER_CMP:
+                return inRange(z.minUser, z.maxUser, value ? n.op : inverse(n.op), n.value);
+            case Kind::TIME_CMP:
+                return inRange(z.minTimestamp, z.maxTimestamp, value ? n.op : inverse(n.op), n.value);
+            case Kind::USER_IN: {
+                auto it = lower_bound(n.users.begin(), n.users.end(), z.minUser);
+                bool mayHit  = it != n.users.end() && *it <= z.maxUser;
+                bool mayMiss = z.minUser != z.maxUser || !mayHit;
+                return value != n.negate ? mayHit : mayMiss;
+            }
+            case Kind::IP_IN: {
+                bool mayHit = false, mayMiss = true;
+                for (const auto& net : n.nets) {
+                    uint32_t last = net.first | ~net.second;
+                    if (net.first <= z.maxIp && last >= z.minIp) mayHit = true;
+                    if (net.first <= z.minIp && last >= z.maxIp) mayMiss = false;
+                }
+                return value != n.negate ? mayHit : mayMiss;
+            }
+            case Kind::LEVEL_IN: {
+                bool mayHit = false, mayMiss = false;
+                for (string_view level : z.levels) {
+                    bool listed = find(n.levels.begin(), n.levels.end(), level) != n.levels.end();
+                    (listed ? mayHit : mayMiss) = true;
+                }
+                return value != n.negate ? mayHit : mayMiss;
+            }
+            case Kind::MESSAGE_ANY:
+            case Kind::MESSAGE_MATCH:
+            default:
+                return true;
+        }
+    }
+
+    // Whether some x in [lo, hi] satisfies "x op rhs"
+    static bool inRange(int64_t lo, int64_t hi, Op op, int64_t rhs) {
+        switch (op) {
+            case Op::EQ: return lo <= rhs && rhs <= hi;
+            case Op::NE: return lo != rhs || hi != rhs;
+            case Op::LT: return lo <  rhs;
+            case Op::LE: return lo <= rhs;
+            case Op::GT: return hi >  rhs;
+            case Op::GE:
+            default:     return hi >= rhs;
+        }
+    }
+
+    // The operator that holds exactly when op does not
+    static Op inverse(Op op) {
+        switch (op) {
+            case Op::EQ: return Op::NE;
+            case Op::NE: return Op::EQ;
+            case Op::LT: return Op::GE;
+            case Op::LE: return Op::GT;
+            case Op::GT: return Op::LE;
+            case Op::GE:
+            default:     return Op::LT;
+        }
+    }
+
+    static bool compare(int64_t lhs, Op op, int64_t rhs) {
+        switch (op) {
+            case Op::EQ: return lhs == rhs;
+            case Op::NE: return lhs != rhs;
+            case Op::LT: return lhs <  rhs;
+            case Op::LE: return lhs <= rhs;
+            case Op::GT: return lhs >  rhs;
+            case Op::GE:
+            default:     return lhs >= rhs;
+        }
+    }
+
+    // Rough per-record cost used to order AND/OR operands
+    int cost(int i) const {
+        const Node& n = nodes[i];
+        switch (n.kind) {
+            case Kind::USER_CMP:
+            case Kind::TIME_CMP: return 1;
+            case Kind::USER_IN:  return 2;
+            case Kind::IP_IN:    return 1 + static_cast<int>(n.nets.size());
+            case Kind::LEVEL_IN: return 3 * static_cast<int>(n.levels.size());
+            case Kind::MESSAGE_ANY: return 1000;
+            case Kind::MESSAGE_MATCH: return 2000;
+            case Kind::NOT:      return cost(n.children[0]);
+            default: {
+                int sum = 0;
+                for (int c : n.children) sum += cost(c);
+                return sum;
+            }
+        }
+    }
+
+    // Makes node the new root, ANDed with the existing expression if any
+    void andWith(int node) {
+        if (root >= 0) {
+            Node both{Kind::AND};
+            both.children = {root, node};
+            node = add(move(both));
+        }
+        root = node;
+        reorder(root);
+    }
+
+    // Also fills in each node's needs
+    void reorder(int i) {
+        if (i < 0) return;
+        Node& n = nodes[i];
+        switch (n.kind) {
+            case Kind::USER_CMP: case Kind::USER_IN: n.needs = LogRecord::USER;      break;
+            case Kind::IP_IN:                        n.needs = LogRecord::IP;        break;
+            case Kind::TIME_CMP:                     n.needs = LogRecord::TIMESTAMP; break;
+            default:                                 n.needs = 0;                    break;
+        }
+        for (int c : n.children) {
+            reorder(c);
+            nodes[i].needs |= nodes[c].needs;
+        }
+        if (n.kind == Kind::AND || n.kind == Kind::OR) {
+            vector<int> kids = n.children;
+            stable_sort(kids.begin(), kids.end(), [&](int a, int b) { return cost(a) < cost(b); });
+            nodes[i].children = kids;
+        }
+    }
+
+    // ---- Parsing ----------------------------------------------------------
+
+    bool tokenize(const string& s) {
+        size_t i = 0;
+        while (i < s.size()) {
+            char c = s[i];
+            if (isspace(static_cast<unsigned char>(c))) { ++i; continue; }
+            if (c == '(' || c == ')' || c == ',') {
+                tokens.push_back({string(1, c)});
+                ++i;
+            } else if (c == '!' || c == '<' || c == '>' || c == '=') {
+                size_t len = (i + 1 < s.size() && s[i + 1] == '=') ? 2 : 1;
+                string op = s.substr(i, len);
+                if (op == "!") return fail("expected '!='");
+                tokens.push_back({op == "==" ? "=" : op});
+                i += len;
+            } else if (c == '\'' || c == '"') {
+                size_t end = s.find(c, i + 1);
+                if (end == string::npos) return fail("unterminated quote");
+                tokens.push_back({s.substr(i + 1, end - i - 1), true});
+                i = end + 1;
+            } else {
+                size_t start = i;
+                while (i < s.size() && !isspace(static_cast<unsigned char>(s[i])) &&
+                       string("(),!<>='\"").find(s[i]) == string::npos) {
+                    ++i;
+                }
+                tokens.push_back({s.substr(start, i - start)});
+            }
+        }
+        return true;
+    }
+
+    bool fail(const string& msg) {
+        if (error.empty()) error = msg;
+        return false;
+    }
+
+    int failNode(const string& msg) {
+        fail(msg);
+        return -1;
+    }
+
+    static string upper(string s) {
+        for (char& c : s) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        return s;
+    }
+
+    // Consumes the next token if it is the given keyword/punctuation
+    bool accept(const string& word) {
+        if (pos < tokens.size() && !tokens[pos].quoted && upper(tokens[pos].text) == word) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool next(Token& t) {
+        if (pos >= tokens.size()) return fail("unexpected end of expression");
+        t = tokens[pos++];
+        return true;
+    }
+
+    int add(Node n) {
+        nodes.push_back(move(n));
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    int parseOr() {
+        int left = parseAnd();
+        if (left < 0 || !accept("OR")) return left;
+        Node n{Kind::OR};
+        n.children.push_back(left);
+        do {
+            int right = parseAnd();
+            if (right < 0) return -1;
+            n.children.push_back(right);
+        } while (accept("OR"));
+        return add(move(n));
+    }
+
+    int parseAnd() {
+        int left = parseNot();
+        if (left < 0 || !accept("AND")) return left;
+        Node n{Kind::AND};
+        n.children.push_back(left);
+        do {
+            int right = parseNot();
+            if (right < 0) return -1;
+            n.children.push_back(right);
+        } while (accept("AND"));
+        return add(move(n));
+    }
+
+    // NOT and parentheses recurse; their nesting is capped so a hostile
+    // filter cannot exhaust the stack (here or in eval())
+    int parseNot() {
+        if (accept("NOT")) {
+            if (++depth > MAX_DEPTH) return failNode("expression nested too deeply");
+            int inner = parseNot();
+            --depth;
+            if (inner < 0) return -1;
+            Node n{Kind::NOT};
+            n.children.push_back(inner);
+            return add(move(n));
+        }
+        if (accept("(")) {
+            if (++depth > MAX_DEPTH) return failNode("expression nested too deeply");
+            int inner = parseOr();
+            --depth;
+            if (inner < 0) return -1;
+            if (!accept(")")) return failNode("expected ')'");
+            return inner;
+        }
+        return parseComparison();
+    }
+
+    // Either "( v, v, ... )" or a single bare value
+    bool parseValues(vector<string>& out) {
+        Token t;
+        if (!accept("(")) {
+            if (!next(t)) return false;
+            out.push_back(t.text);
+            return true;
+        }
+        do {
+            if (!next(t)) return false;
+            out.push_back(t.text);
+        } while (accept(","));
+        if (!accept(")")) return fail("expected ')' after value list");
+        return true;
+    }
+
+    int parseComparison() {
+        Token fieldTok;
+        if (!next(fieldTok)) return -1;
+        string field = upper(fieldTok.text);
+        if (field != "LEVEL" && field != "USER" && field != "IP" && field != "TIME" &&
+            field != "MESSAGE") {
+            return failNode("unknown field '" + fieldTok.text + "'");
+        }
+        if (field == "MESSAGE") return parseContains();
+
+        // Set membership: [NOT] IN
+        bool negate = false;
+        if (accept("NOT")) {
+            if (!accept("IN")) return failNode("expected IN after NOT");
+            negate = true;
+        } else if (!accept("IN")) {
+            return parseOperator(field);
+        }
+        vector<string> values;
+        if (!parseValues(values)) return -1;
+        return buildSet(field, values, negate);
+    }
+
+    int parseContains() {
+        Node n{Kind::MESSAGE_ANY};
+        n.negate = accept("NOT");
+        if (accept("MATCHES")) {
+            Token pattern;
+            if (!next(pattern)) return -1;
+            auto regex = make_shared<RegexDFA>();
+            string err;
+            if (!regex->compile(pattern.text, err)) return failNode("invalid regex: " + err);
+            n.kind  = Kind::MESSAGE_MATCH;
+            n.regex = regex;
+            return add(move(n));
+        }
+        if (!accept("CONTAINS")) return failNode("message supports only [NOT] CONTAINS and [NOT] MATCHES");
+        vector<string> patterns;
+        if (!parseValues(patterns)) return -1;
+        auto matcher = make_shared<AhoCorasick>();
+        if (!matcher->build(patterns)) return failNode("invalid CONTAINS patterns");
+        n.matcher = matcher;
+        return add(move(n));
+    }
+
+    int parseOperator(const string& field) {
+        Token opTok, valTok;
+        if (!next(opTok) || !next(valTok)) return -1;
+        static const pair<const char*, Op> ops[] = {
+            {"=", Op::EQ}, {"!=", Op::NE}, {"<", Op::LT}, {"<=", Op::LE}, {">", Op::GT}, {">=", Op::GE}};
+        Op op = Op::EQ;
+        bool found = false;
+        for (const auto& o : ops) {
+            if (!opTok.quoted && opTok.text == o.first) { op = o.second; found = true; }
+        }
+        if (!found) return failNode("expected comparison operator after " + field);
+
+        if (field == "LEVEL" || field == "IP") {
+            if (op != Op::EQ && op != Op::NE) {
+                return failNode(field + " supports only =, != and IN");
+            }
+            return buildSet(field, {valTok.text}, op == Op::NE);
+        }
+        Node n{field == "USER" ? Kind::USER_CMP : Kind::TIME_CMP};
+        n.op = op;
+        if (field == "USER") {
+            uint32_t id;
+            if (!parseUserId(valTok.text, id)) return failNode("invalid user id '" + valTok.text + "'");
+            n.value = id;
+        } else if (!parseTimestamp(valTok.text, n.value)) {
+            return failNode("invalid time '" + valTok.text + "'");
+        } else if (valTok.text.size() < 19) {
+            return dateComparison(op, n.value);
+        }
+        return add(move(n));
+    }
+
+    /**
+     * A bare date stands for the whole day, as FROM/TO do: "<= day" and
+     * "> day" compare against its last second, "= day" and "!= day" test
+     * the range [midnight, 23:59:59].
+     */
+    int dateComparison(Op op, int64_t day) {
+        const int64_t last = day + 86399;
+        auto cmp = [&](Op o, int64_t v) {
+            Node n{Kind::TIME_CMP};
+            n.op    = o;
+            n.value = v;
+            return add(move(n));
+        };
+        switch (op) {
+            case Op::LE: return cmp(Op::LE, last);
+            case Op::GT: return cmp(Op::GT, last);
+            case Op::LT: case Op::GE: return cmp(op, day);
+            case Op::EQ:
+            case Op::NE:
+            default: {
+                bool eq = op == Op::EQ;
+                Node both{eq ? Kind::AND : Kind::OR};
+                both.children = {cmp(eq ? Op::GE : Op::LT, day), cmp(eq ? Op::LE : Op::GT, last)};
+                return add(move(both));
+            }
+        }
+    }
+
+    int buildSet(const string& field, const vector<string>& values, bool negate) {
+        if (field == "TIME") return failNode("time supports only comparison operators");
+        Node n{Kind::LEVEL_IN};
+        n.negate = negate;
+        if (field == "LEVEL") {
+            n.levels = values;
+        } else if (field == "USER") {
+            n.kind = Kind::USER_IN;
+            for (const auto& v : values) {
+                uint32_t id;
+                if (!parseUserId(v, id)) return failNode("invalid user id '" + v + "'");
+                n.users.push_back(id);
+            }
+            sort(n.users.begin(), n.users.end());
+        } else {
+            n.kind = Kind::IP_IN;
+            for (const auto& v : values) {
+                uint32_t network;
+                int bits;
+                if (!parseCIDR(v, network, bits)) return failNode("invalid address or CIDR '" + v + "'");
+                n.nets.push_back({network, prefixMask(bits)});
+            }
+        }
+        return add(move(n));
+    }
+
+    vector<Node>  nodes;
+    int           root = -1;
+
+    // Parser state, only used inside compile()
+    static constexpr int MAX_DEPTH = 64;  ///< Nested NOTs and parentheses
+    vector<Token> tokens;
+    size_t        pos = 0;
+    int           depth = 0;
+    string        error;
+};
+
+#endif // RECORD_FILTER_HPP
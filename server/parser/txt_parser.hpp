@@ -5,8 +5,8 @@
 #define TXT_PARSER_HPP
 
 #include "log_parser.hpp"
+#include "../util/async_logger.hpp"
 #include <sstream>
-#include <iostream>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -33,7 +33,7 @@ public:
     /**
      * Parses each line in the text payload and aggregates counts based on AnalysisType.
      * Expects each non-empty line to be delimited by "|" into exactly five parts.
-     * Logs with fewer parts are skipped with a warning.
+     * Logs with fewer parts are skipped and tallied (see malformedTally()).
      *
      * @param type Dimension for analysis: BY_USER, BY_IP, or BY_LOG_LEVEL.
      * @return unordered_map where the key is user ID, IP address, or log level,
@@ -43,11 +43,10 @@ public:
         unordered_map<string, int> result;
         istringstream stream(dataStr);
         string line;
-        int lineNo = 0;
+        size_t skipped = 0;
 
         // Process each line in the payload
         while (getline(stream, line)) {
-            ++lineNo;
             if (line.empty()) continue;  // skip blank lines
 
             // Split the line into parts separated by '|'
@@ -64,16 +63,12 @@ public:
 
             // Validate expected format: timestamp | level | message | UserID: X | IP: Y
             if (parts.size() < 5) {
-                cerr << "[WARN] Skipping malformed line " << lineNo
-                          << ": expected 5 fields but got " << parts.size()
-                          << " => '" << line << "'\n";
+                ++skipped;
                 continue;
             }
 
             // Extract individual fields
-            const string& timestamp = parts[0];           // e.g. "2024-09-30 22:51:48"
             const string& level     = parts[1];           // e.g. "INFO"
-            const string& message   = parts[2];           // free-text message
             const string& userField = parts[3];           // "UserID: 2421"
             const string& ipField   = parts[4];           // "IP: 84.126.98.62"
 
@@ -108,15 +103,78 @@ public:
             }
             // trim before push into unordered_map to avoid hidden \n in txt file
             size_t start = key.find_first_not_of(" \t\r\n");
+            if (start == string::npos) continue;  // nothing to count under
             size_t end   = key.find_last_not_of(" \t\r\n");
             key = key.substr(start, end - start + 1);
             result[key]++;
         }
+        if (skipped > 0) malformedTally().add(skipped);
 
         return result;
     }
 
+    /**
+     * Visits each line parse() accepts as a LogRecord (see makeRecord() for
+     * fields that do not convert). Fields are sliced out of the payload in
+     * place; malformed lines are counted and tallied once at the end instead
+     * of logged per line.
+     *
+     * @param visit Callback invoked once per record.
+     */
+    void forEachRecord(const RecordVisitor& visit) override {
+        auto trim = [](string_view s) {
+            size_t start = s.find_first_not_of(" \t\r\n");
+            if (start == string_view::npos) return string_view();
+            size_t end = s.find_last_not_of(" \t\r\n");
+            return s.substr(start, end - start + 1);
+        };
+        // "UserID: 2421" -> "2421"
+        auto afterColon = [&](string_view field) {
+            size_t pos = field.find(':');
+            return pos == string_view::npos ? string_view() : trim(field.substr(pos + 1));
+        };
+
+        string_view data(dataStr);
+        size_t skipped = 0;
+        size_t pos = 0;
+        while (pos < data.size()) {
+            size_t eol = data.find('\n', pos);
+            if (eol == string_view::npos) eol = data.size();
+            string_view line = data.substr(pos, eol - pos);
+            pos = eol + 1;
+            if (trim(line).empty()) continue;
+
+            // Split into the five '|' separated fields; a bar at the very end
+            // starts no field, as with parse()'s getline split
+            string_view parts[5];
+            size_t count = 0, fieldStart = 0;
+            while (count < 5) {
+                size_t bar = line.find('|', fieldStart);
+                parts[count++] = trim(line.substr(fieldStart, bar == string_view::npos
+                                                                 ? string_view::npos
+                                                                 : bar - fieldStart));
+                if (bar == string_view::npos || bar + 1 == line.size()) break;
+                fieldStart = bar + 1;
+            }
+
+            if (count < 5) {
+                ++skipped;
+                continue;
+            }
+            LogRecord rec;
+            makeRecord(parts[0], parts[1], parts[2], afterColon(parts[3]), afterColon(parts[4]), rec);
+            if (accept(rec)) visit(rec);
+        }
+        if (skipped > 0) malformedTally().add(skipped);
+    }
+
 private:
+    // Malformed lines across all payloads, logged at most once a second
+    static LogTally& malformedTally() {
+        static LogTally tally(asyncLogger, LogLevel::WARN, "malformed TXT line(s) skipped", "payload(s)");
+        return tally;
+    }
+
     string dataStr;  ///< Raw text payload containing all log lines
 };
 
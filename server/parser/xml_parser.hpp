@@ -85,6 +85,45 @@ public:
         return result;
     }
 
+    /**
+     * Visits each <log>...</log> block as a LogRecord.
+     * Tag values are sliced out of the payload in place; fields that do not
+     * convert are flagged as makeRecord() describes.
+     *
+     * @param visit Callback invoked once per record.
+     */
+    void forEachRecord(const RecordVisitor& visit) override {
+        string_view data(dataStr);
+
+        // Inner text of <tag>...</tag> within a single <log> block
+        auto getTagValue = [](string_view s, string_view open, string_view close) -> string_view {
+            size_t p1 = s.find(open);
+            if (p1 == string_view::npos) return {};
+            p1 += open.size();
+            size_t p2 = s.find(close, p1);
+            if (p2 == string_view::npos) return {};
+            return s.substr(p1, p2 - p1);
+        };
+
+        size_t pos = 0;
+        while (true) {
+            size_t start = data.find("<log>", pos);
+            if (start == string_view::npos) break;
+            size_t end = data.find("</log>", start);
+            if (end == string_view::npos) break;
+            string_view entry = data.substr(start + 5, end - (start + 5));
+            pos = end + 6;
+
+            LogRecord rec;
+            makeRecord(getTagValue(entry, "<timestamp>", "</timestamp>"),
+                       getTagValue(entry, "<log_level>", "</log_level>"),
+                       getTagValue(entry, "<message>", "</message>"),
+                       getTagValue(entry, "<user_id>", "</user_id>"),
+                       getTagValue(entry, "<ip_address>", "</ip_address>"), rec);
+            if (accept(rec)) visit(rec);
+        }
+    }
+
 private:
     string dataStr;  ///< Raw XML payload to be parsed
 };
@@ -8,12 +8,35 @@
 #include <netinet/in.h>
 #include <unistd.h>
 #include <cstring>
+#include <memory>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/time.h>
 
 #include "parser/log_parser.hpp"
 #include "parser/json_parser.hpp"
 #include "parser/txt_parser.hpp"
 #include "parser/xml_parser.hpp"
+#include "parser/bin_parser.hpp"
+#include "parser/date_filter.hpp"
 #include "parser/lib/nlohmann/json.hpp"
+#include "store/dataset_store.hpp"
+#include "cache/result_cache.hpp"
+#include "cache/incremental_store.hpp"
+#include "util/async_logger.hpp"
+#include "util/xxhash64.hpp"
+#include "analysis/time_histogram.hpp"
+#include "analysis/top_k.hpp"
+#include "analysis/hyperloglog.hpp"
+#include "analysis/group_by.hpp"
+#include "analysis/cidr_table.hpp"
+#include "metrics/stage_timer.hpp"
+#include "metrics/server_metrics.hpp"
+#include "metrics/trace_recorder.hpp"
 
 #define PORT 8080
 #define BUFFER_SIZE 8192
@@ -21,141 +44,827 @@
 using namespace std;
 using json = nlohmann::json;
 
-// Enumeration of supported log formats
-enum class FileType { JSON, XML, TXT };
-
-// Detect file type based on first non-whitespace character
-FileType detectFileType(const string& body) {
-    auto p = body.find_first_not_of(" \t\r\n");
-    if (p == string::npos) return FileType::TXT;
-    char c = body[p];
-    if (c == '[' || c == '{') return FileType::JSON;
-    if (c == '<')            return FileType::XML;
-    return FileType::TXT;
+// Pick the parser for a payload, applying the date-range filter first
+LogParser* createParser(const string& body, const string& fromDate, const string& toDate) {
+    switch (detectFileType(body)) {
+        case FileType::JSON:
+            return new JSONParser(filterJsonByDate(body, fromDate, toDate));
+        case FileType::TXT:
+            return new TXTParser(filterTxtByDate(body, fromDate, toDate));
+        case FileType::XML:
+            return new XMLParser(filterXmlByDate(body, fromDate, toDate));
+        case FileType::BIN: {
+            // Binary payloads are filtered inside the parser using the timestamp column
+            BINParser* bin = new BINParser(body);
+            bin->setDateRange(fromDate, toDate);
+            return bin;
+        }
+    }
+    return nullptr;
 }
 
-// Filter JSON logs by date range (YYYY-MM-DD)
-string filterJsonByDate(const string& jsonBody,
-                             const string& fromDate,
-                             const string& toDate) {
-    json arr;
-    try {
-        istringstream iss(jsonBody);
-        iss >> arr;
-    } catch (...) {
-         // Return original if parsing fails
-        return jsonBody; 
-    }
-    json filtered = json::array();
-    for (auto& entry : arr) {
-        string ts = entry.value("timestamp", "");
-        if (ts.size() >= 10) {
-            string date = ts.substr(0, 10);
-            if ((!fromDate.empty() && date < fromDate) ||
-                (!toDate.empty()   && date > toDate)) {
-                continue;
+// Render an analysis result as "key: count" lines
+string formatResult(const unordered_map<string, int>& result) {
+    ostringstream resp;
+    if (result.empty()) {
+        resp << "[INFO] No entries matched your query.\n";
+    } else {
+        for (const auto& pair : result) {
+            resp << pair.first << ": ";
+            resp << pair.second << "\n";
+        }
+    }
+    return resp.str();
+}
+
+/**
+ * What to compute over the selected records: one of the flat AnalysisType
+ * counts (optionally only the TOP k of them, exact or sketched),
+ * TYPE:HISTOGRAM with its BUCKET width and optional SPLIT:LOG_LEVEL, or
+ * TYPE:DISTINCT estimating the number of different FIELD values, or counts
+ * per GROUP_BY tuple in a flat or nested LAYOUT, or IP counts rolled up by
+ * CIDR prefix length or named blocks. Any of them can be narrowed
+ * by a WHERE filter evaluated inside the parser's record loop.
+ */
+struct AnalysisOptions {
+    shared_ptr<const RecordFilter> filter;  ///< Compiled WHERE expression, if any
+    string  whereText;                      ///< Its source, for the cache key
+    AnalysisType type = AnalysisType::BY_LOG_LEVEL;  ///< Grouping key, or FIELD for DISTINCT
+    vector<GroupDim> groupBy;     ///< Composite key; non-empty selects group-by
+    bool    nested      = false;  ///< LAYOUT:NESTED for group-by
+    int     cidrBits    = -1;     ///< CIDR:<bits> roll-up, -1 if unused
+    shared_ptr<const CidrTable> cidrTable;  ///< CIDR:<name=block,...> roll-up
+    string  cidrText;             ///< CIDR header, for the cache key
+    bool    distinct    = false;
+    int     precision   = 12;     ///< HyperLogLog index bits for DISTINCT
+    bool    histogram   = false;
+    int64_t bucketWidth = 3600;
+    bool    splitLevels = false;
+    size_t  topK        = 0;      ///< 0 = every key
+    bool    topSketch   = false;  ///< Space-Saving instead of exact partial sort
+
+    // Normalized form used in result cache keys
+    string cacheKey() const {
+        static const char* typeNames[] = {"USER", "IP", "LOG_LEVEL"};
+        ostringstream key;
+        if (cidrBits >= 0 || cidrTable) {
+            key << "CIDR " << cidrText;
+        } else if (!groupBy.empty()) {
+            key << "GROUP";
+            for (GroupDim d : groupBy) key << '/' << static_cast<int>(d);
+            key << (nested ? "/NESTED" : "/FLAT");
+        } else if (histogram) {
+            key << "HISTOGRAM/" << bucketWidth << (splitLevels ? "/LEVEL" : "");
+        } else if (distinct) {
+            key << "DISTINCT/" << typeNames[static_cast<int>(type)] << '/' << precision;
+        } else {
+            key << typeNames[static_cast<int>(type)];
+        }
+        if (topK > 0)  key << "/TOP" << topK << (topSketch ? "S" : "E");
+        if (filter)    key << "/WHERE " << whereText;
+        return key.str();
+    }
+};
+
+// Counters per sketched key: a multiple of k so the reported k are reliable
+const size_t TOP_SKETCH_FACTOR = 4;
+const size_t MAX_TOP_K = 1000000;
+
+/**
+ * TOP:k with TOP_MODE:SKETCH - heavy hitters in O(k) memory. Users and IPs are
+ * sketched as integers; levels are interned to small ids first.
+ */
+string topSketch(LogParser& parser, AnalysisType type, size_t k) {
+    SpaceSaving<uint32_t> sketch(k * TOP_SKETCH_FACTOR);
+    vector<string> levels;
+    parser.forEachRecord([&](const LogRecord& rec) {
+        switch (type) {
+            case AnalysisType::BY_USER: if (rec.has(LogRecord::USER)) sketch.add(rec.userId); break;
+            case AnalysisType::BY_IP:   if (rec.has(LogRecord::IP))   sketch.add(rec.ip);     break;
+            case AnalysisType::BY_LOG_LEVEL:
+            default: {
+                uint32_t id = 0;
+                while (id < levels.size() && levels[id] != rec.level) ++id;
+                if (id == levels.size()) levels.emplace_back(rec.level);
+                sketch.add(id);
+                break;
             }
         }
-        filtered.push_back(entry);
+    });
+
+    ostringstream resp;
+    if (sketch.total() == 0) {
+        resp << "[INFO] No entries matched your query.\n";
+        return resp.str();
+    }
+    resp << "[INFO] Top " << k << " of " << sketch.total() << " records (Space-Saving, "
+         << sketch.capacity() << " counters, counts overestimate by at most "
+         << sketch.total() / sketch.capacity() << ")\n";
+    for (const auto& e : sketch.top(k)) {
+        switch (type) {
+            case AnalysisType::BY_USER: resp << e.key; break;
+            case AnalysisType::BY_IP:   resp << formatIPv4(e.key); break;
+            default:                    resp << levels[e.key]; break;
+        }
+        resp << ": " << e.count;
+        if (e.error > 0) resp << " (error <= " << e.error << ")";
+        resp << "\n";
     }
-    return filtered.dump();
+    return resp.str();
 }
 
-// Filter TXT lines by date range ("YYYY-MM-DD")
-string filterTxtByDate(const string& txtBody,
-                            const string& fromDate,
-                            const string& toDate) {
-    istringstream iss(txtBody);
-    ostringstream oss;
-    string line;
-    while (getline(iss, line)) {
-        if (line.size() < 10) continue;
-        string date = line.substr(0, 10);
-        if ((!fromDate.empty() && date < fromDate) ||
-            (!toDate.empty()   && date > toDate)) {
-            continue;
+// TYPE:DISTINCT - HyperLogLog over the FIELD values of every record
+HyperLogLog distinctSketch(LogParser& parser, const AnalysisOptions& opts) {
+    HyperLogLog hll(opts.precision);
+    parser.setFilter(opts.filter.get());
+    parser.forEachRecord([&](const LogRecord& rec) {
+        switch (opts.type) {
+            case AnalysisType::BY_USER:
+                if (rec.has(LogRecord::USER)) hll.addHash(HyperLogLog::mix64(rec.userId));
+                break;
+            case AnalysisType::BY_IP:
+                if (rec.has(LogRecord::IP)) hll.addHash(HyperLogLog::mix64(rec.ip));
+                break;
+            case AnalysisType::BY_LOG_LEVEL:
+            default:
+                hll.addHash(XXHash64::hash(rec.level.data(), rec.level.size()));
+                break;
+        }
+    });
+    return hll;
+}
+
+// Estimate, standard error and a ~95% range (two standard errors) as "name: value" lines
+string formatDistinct(const HyperLogLog& hll, AnalysisType field) {
+    static const char* fieldNames[] = {"user", "ip", "log_level"};
+    double est = hll.estimate();
+    double err = hll.standardError();
+    ostringstream resp;
+    resp << "distinct_" << fieldNames[static_cast<int>(field)] << ": " << llround(est) << "\n"
+         << "standard_error: " << err * 100 << "%\n"
+         << "range_95: " << llround(est * (1 - 2 * err)) << "-" << llround(est * (1 + 2 * err)) << "\n"
+         << "sketch_bytes: " << hll.memoryBytes() << "\n";
+    return resp.str();
+}
+
+// Flat counts built from forEachRecord, so a WHERE filter is applied per record.
+// Text formats are keyed on the field text as written and skip empty keys, as
+// parse() does, so an always-true filter changes nothing; BIN records carry
+// only integers, which are counted first and rendered once.
+unordered_map<string, int> countRecords(LogParser& parser, AnalysisType type) {
+    unordered_map<uint32_t, int> byId;
+    unordered_map<string, int> result;
+    const bool text = parser.hasFieldText();
+    parser.forEachRecord([&](const LogRecord& rec) {
+        string_view key;
+        switch (type) {
+            case AnalysisType::BY_USER:
+                if (!text) { ++byId[rec.userId]; return; }
+                key = rec.userText;
+                break;
+            case AnalysisType::BY_IP:
+                if (!text) { ++byId[rec.ip]; return; }
+                key = rec.ipText;
+                break;
+            case AnalysisType::BY_LOG_LEVEL:
+            default:
+                key = rec.level;
+                break;
         }
-        oss << line << "\n";
+        if (!key.empty()) ++result[string(key)];
+    });
+    for (const auto& kv : byId) {
+        result[type == AnalysisType::BY_IP ? formatIPv4(kv.first) : to_string(kv.first)] = kv.second;
+    }
+    return result;
+}
+
+/**
+ * CIDR:<bits> - IP counts per /bits network, in address order.
+ * CIDR:<name=block,...> - counts per named block (longest prefix wins), in the
+ * order the names were given, then addresses outside every block.
+ * Both work on the integer address inside the record loop.
+ */
+string cidrRollup(LogParser& parser, const AnalysisOptions& opts) {
+    ostringstream resp;
+    if (opts.cidrTable) {
+        const CidrTable& table = *opts.cidrTable;
+        vector<uint64_t> counts(table.size(), 0);
+        uint64_t unmatched = 0, total = 0;
+        parser.forEachRecord([&](const LogRecord& rec) {
+            if (!rec.has(LogRecord::IP)) return;
+            uint32_t label = table.lookup(rec.ip);
+            if (label == CidrTable::NO_MATCH) ++unmatched;
+            else ++counts[label];
+            ++total;
+        });
+        if (total == 0) return formatResult({});
+        for (uint32_t l = 0; l < counts.size(); ++l) resp << table.name(l) << ": " << counts[l] << "\n";
+        resp << "(unmatched): " << unmatched << "\n";
+        return resp.str();
+    }
+
+    const uint32_t mask = prefixMask(opts.cidrBits);
+    unordered_map<uint32_t, uint64_t> counts;
+    parser.forEachRecord([&](const LogRecord& rec) {
+        if (rec.has(LogRecord::IP)) ++counts[rec.ip & mask];
+    });
+    if (counts.empty()) return formatResult({});
+    vector<pair<uint32_t, uint64_t>> rows(counts.begin(), counts.end());
+    sort(rows.begin(), rows.end());
+    for (const auto& kv : rows) {
+        resp << formatIPv4(kv.first) << "/" << opts.cidrBits << ": " << kv.second << "\n";
+    }
+    return resp.str();
+}
+
+// Run the requested analysis over a parser and render the response body
+string runAnalysis(LogParser& parser, const AnalysisOptions& opts) {
+    parser.setFilter(opts.filter.get());
+    if (opts.cidrBits >= 0 || opts.cidrTable) {
+        return cidrRollup(parser, opts);
+    }
+    if (!opts.groupBy.empty()) {
+        GroupBy groups(opts.groupBy);
+        parser.forEachRecord([&](const LogRecord& rec) { groups.add(rec); });
+        return groups.format(opts.nested);
+    }
+    if (opts.distinct) {
+        return formatDistinct(distinctSketch(parser, opts), opts.type);
     }
-    return oss.str();
+    if (opts.histogram) {
+        TimeHistogram hist(opts.bucketWidth, opts.splitLevels);
+        parser.forEachRecord([&](const LogRecord& rec) { hist.add(rec); });
+        return hist.format();
+    }
+    if (opts.topK > 0 && opts.topSketch) {
+        return topSketch(parser, opts.type, opts.topK);
+    }
+    auto result = opts.filter ? countRecords(parser, opts.type) : parser.parse(opts.type);
+    if (opts.topK == 0 || result.empty()) return formatResult(result);
+
+    ostringstream resp;
+    resp << "[INFO] Top " << min(opts.topK, result.size()) << " of " << result.size()
+         << " keys (exact)\n";
+    for (const auto& kv : topExact(result, opts.topK)) {
+        resp << kv.first << ": " << kv.second << "\n";
+    }
+    return resp.str();
 }
 
-// Filter XML payload by date range ("YYYY-MM-DD")
-static string filterXmlByDate(const string& xmlBody,
-                                   const string& fromDate,
-                                   const string& toDate) {
-    auto getTagValue = [&](const string& s, const string& tag) -> string {
-        string open  = "<"  + tag + ">";
-        string close = "</" + tag + ">";
-        size_t p1 = s.find(open);
-        if (p1 == string::npos) return "";
-        p1 += open.size();
-        size_t p2 = s.find(close, p1);
-        if (p2 == string::npos) return "";
-        return s.substr(p1, p2 - p1);
+// Connections, requests, bytes and parse volume, sharded per client thread
+ServerMetrics serverMetrics;
+
+// Send the whole buffer, retrying on partial writes
+bool sendAll(int sock, const string& out) {
+    if (out.rfind("[ERROR]", 0) == 0) serverMetrics.countError();
+    size_t sent = 0;
+    while (sent < out.size()) {
+        ssize_t n = send(sock, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += static_cast<size_t>(n);
+    }
+    serverMetrics.addBytesOut(sent);
+    return sent == out.size();
+}
+
+// Datasets uploaded with CMD:INGEST, shared by all client threads
+DatasetStore datasetStore;
+
+// Responses of recent ANALYZE requests, keyed by body hash + normalized header
+ResultCache resultCache(64ULL << 20);
+
+// Per-file aggregates for CMD:APPEND (incremental re-analysis of growing logs)
+IncrementalStore incrementalStore;
+
+/**
+ * CMD:APPEND - merge the counts of a newly appended TXT tail into the totals
+ * remembered for FILE. The client proves it is continuing the same prefix by
+ * sending OFFSET and the XXH64 of its own file's first OFFSET bytes as
+ * PREFIX_HASH, which must equal the hash of the bytes this server received;
+ * on any mismatch the reply is "RESYNC" and the client resends from offset 0.
+ * Reply: "OFFSET:<n>", "PREFIX_HASH:<hex>", blank line, merged result.
+ */
+string appendIncremental(const string& fileId, AnalysisType type,
+                         const string& fromDate, const string& toDate,
+                         uint64_t offset, uint64_t prefixHash, const string& body) {
+    if (fileId.empty()) return "[ERROR] APPEND requires FILE\n";
+    if (!body.empty() && detectFileType(body) != FileType::TXT) {
+        return "[ERROR] APPEND supports line-oriented TXT logs only\n";
+    }
+    ostringstream key;
+    key << fileId << '|' << static_cast<int>(type) << '|' << fromDate << '|' << toDate;
+
+    IncrementalState st;
+    if (!incrementalStore.checkout(key.str(), offset, prefixHash, st)) {
+        return "RESYNC\n";
+    }
+
+    // Only the new bytes are filtered and parsed
+    TXTParser parser(filterTxtByDate(body, fromDate, toDate));
+    for (const auto& kv : parser.parse(type)) st.counts[kv.first] += kv.second;
+    st.prefixHash.update(body);
+    st.offset += body.size();
+
+    ostringstream resp;
+    resp << "OFFSET:" << st.offset << "\n"
+         << "PREFIX_HASH:" << hex << st.prefixHash.digest() << dec << "\n\n";
+    string result = formatResult(st.counts);
+    if (!incrementalStore.commit(key.str(), offset, move(st))) {
+        return "RESYNC\n";
+    }
+    LOG(INFO) << "Appended " << body.size() << " bytes to " << fileId;
+    return resp.str() + result;
+}
+
+/**
+ * CMD:FOLLOW - long-lived session for a tailed TXT log. After the header the
+ * client keeps streaming appended lines on the same connection; complete
+ * lines are parsed as they arrive and the counts gained since the last push
+ * are sent as
+ *   DELTA <seq> <total records>
+ *   <key>: +<n>
+ *   <blank line>
+ * every intervalMs milliseconds or after batch records, whichever comes first.
+ * When the client half-closes, the running counters are sent once as a
+ * "TOTAL <records>" block and the session ends.
+ */
+void followStream(int sock, AnalysisType type, const string& fromDate, const string& toDate,
+                  int intervalMs, uint64_t batch, string pending) {
+    unordered_map<string, int> totals, delta;
+    uint64_t records = 0, deltaRecords = 0, seq = 0;
+
+    // Parse every complete line in pending; a partial last line waits for more bytes
+    auto consume = [&]() {
+        size_t lastNl = pending.rfind('\n');
+        if (lastNl == string::npos) {
+            if (pending.size() > (1u << 20)) {
+                LOG(WARN) << "Follow: dropping " << pending.size() << " bytes without a newline";
+                pending.clear();
+            }
+            return;
+        }
+        TXTParser parser(filterTxtByDate(pending.substr(0, lastNl + 1), fromDate, toDate));
+        for (const auto& kv : parser.parse(type)) {
+            delta[kv.first]  += kv.second;
+            totals[kv.first] += kv.second;
+            deltaRecords     += kv.second;
+        }
+        pending.erase(0, lastNl + 1);
+    };
+    auto push = [&]() {
+        if (delta.empty()) return true;
+        records += deltaRecords;
+        ostringstream msg;
+        msg << "DELTA " << ++seq << " " << records << "\n";
+        for (const auto& kv : delta) msg << kv.first << ": +" << kv.second << "\n";
+        msg << "\n";
+        delta.clear();
+        deltaRecords = 0;
+        return sendAll(sock, msg.str());
     };
 
-    string filtered = "<logs>";
-    size_t pos = 0;
+    const auto interval = chrono::milliseconds(intervalMs);
+    auto nextPush = chrono::steady_clock::now() + interval;
+    char buffer[BUFFER_SIZE];
+    consume();
+    bool open = true;
+    while (open) {
+        if (deltaRecords >= batch && !push()) return;
+        auto now = chrono::steady_clock::now();
+        if (now >= nextPush) {
+            if (!push()) return;
+            nextPush = now + interval;
+        }
+        int waitMs = static_cast<int>(
+            chrono::duration_cast<chrono::milliseconds>(nextPush - now).count());
+        pollfd pfd{sock, POLLIN, 0};
+        int rc = poll(&pfd, 1, waitMs);
+        if (rc < 0 && errno != EINTR) break;
+        if (rc > 0) {
+            ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                open = false;
+            } else {
+                pending.append(buffer, static_cast<size_t>(n));
+                consume();
+            }
+        }
+    }
+
+    // Client finished: an unterminated last line still counts
+    if (!pending.empty()) pending += '\n';
+    consume();
+    if (!push()) return;
+    ostringstream final;
+    final << "TOTAL " << records << "\n" << formatResult(totals) << "\n";
+    sendAll(sock, final.str());
+    LOG(INFO) << "Follow session ended after " << records << " records, "
+              << seq << " update(s)";
+}
+
+// Per-stage latency of completed requests, across all client threads
+StageStats stageStats;
+
+// Requests slower than this are logged with their stage breakdown (0 = off)
+uint64_t slowRequestMs = 1000;
+
+// Listening socket of the main port, for the accept queue gauge
+int listenSocket = -1;
+
+// Request spans for CMD:TRACE / GET /trace (off unless --trace-events N)
+TraceRecorder traceRecorder;
+
+// Hardware counters around filtering and parsing (--perf-counters)
+bool perfCountersOn = false;
+
+// The calling thread's counter group, opened on first use; nullptr if off or unavailable
+PerfCounters* threadPerfCounters() {
+    if (!perfCountersOn) return nullptr;
+    thread_local PerfCounters counters;
+    thread_local bool tried = false;
+    if (!tried) {
+        tried = true;
+        string err;
+        if (!counters.open(err)) {
+            LOG_EVERY(WARN, 1) << "Hardware counters unavailable: " << err;
+        }
+    }
+    return counters.isOpen() ? &counters : nullptr;
+}
+
+// CMD:STATS - server counters as "name: value" lines
+string formatStats() {
+    ResultCache::Stats cs = resultCache.snapshot();
+    ostringstream resp;
+    resp << "cache_hits: "       << cs.hits << "\n"
+         << "cache_misses: "     << cs.misses << "\n"
+         << "cache_hit_ratio: "  << cs.hitRatio() << "\n"
+         << "cache_evictions: "  << cs.evictions << "\n"
+         << "cache_entries: "    << cs.entries << "\n"
+         << "cache_bytes: "      << cs.bytes << "\n"
+         << "cache_capacity_bytes: " << cs.capacity << "\n"
+         << "incremental_files: " << incrementalStore.size() << "\n";
+    if (perfCountersOn) {
+        // Per parsed body byte, over all ANALYZE cache misses so far
+        ServerMetrics::Totals t = serverMetrics.snapshot();
+        double perByte = t.parseBytes ? 1.0 / double(t.parseBytes) : 0.0;
+        resp << "parse_ipc: "                 << t.parseCounters.ipc() << "\n"
+             << "parse_cycles_per_byte: "     << t.parseCounters.cycles * perByte << "\n"
+             << "parse_cache_misses_per_kb: " << t.parseCounters.cacheMisses * perByte * 1024 << "\n"
+             << "parse_branch_misses_per_kb: " << t.parseCounters.branchMisses * perByte * 1024 << "\n";
+    }
+    resp << stageStats.format();
+    return resp.str();
+}
+
+// Prometheus text for the admin port: formatStats() plus the request counters
+string formatMetrics() {
+    ServerMetrics::Totals t = serverMetrics.snapshot();
+    ResultCache::Stats cs = resultCache.snapshot();
+    PromText prom;
+
+    prom.family("logserver_active_connections", "gauge", "Client connections being handled.");
+    prom.sample("logserver_active_connections", "", t.activeConnections());
+    // Connections are served by a thread each, so the only queue is the
+    // kernel's accept backlog (TCP_INFO reports it for a listening socket)
+    tcp_info ti{};
+    socklen_t tiLen = sizeof(ti);
+    if (listenSocket >= 0 && getsockopt(listenSocket, IPPROTO_TCP, TCP_INFO, &ti, &tiLen) == 0) {
+        prom.family("logserver_accept_queue_depth", "gauge",
+                    "Connections waiting in the listen backlog to be accepted.");
+        prom.sample("logserver_accept_queue_depth", "", ti.tcpi_unacked);
+    }
+
+    prom.family("logserver_requests_total", "counter", "Requests handled, by command, body format and analysis type.");
+    for (size_t c = 0; c < METRIC_COMMAND_COUNT; ++c) {
+        for (size_t f = 0; f < METRIC_FORMAT_COUNT; ++f) {
+            for (size_t ty = 0; ty < METRIC_TYPE_COUNT; ++ty) {
+                uint64_t n = t.requests[ServerMetrics::requestIndex(c, f, ty)];
+                if (!n) continue;
+                prom.sample("logserver_requests_total",
+                            string("command=\"") + METRIC_COMMANDS[c] + "\",format=\"" + METRIC_FORMATS[f]
+                                + "\",type=\"" + METRIC_TYPES[ty] + "\"", n);
+            }
+        }
+    }
+    prom.family("logserver_request_errors_total", "counter", "Replies that began with [ERROR].");
+    prom.sample("logserver_request_errors_total", "", t.errors);
+    prom.family("logserver_received_bytes_total", "counter", "Request bytes received, headers included.");
+    prom.sample("logserver_received_bytes_total", "", t.bytesIn);
+    prom.family("logserver_sent_bytes_total", "counter", "Reply bytes sent.");
+    prom.sample("logserver_sent_bytes_total", "", t.bytesOut);
+    prom.family("logserver_parse_bytes_total", "counter", "Body bytes filtered and parsed by ANALYZE cache misses.");
+    prom.sample("logserver_parse_bytes_total", "", t.parseBytes);
+    prom.family("logserver_parse_seconds_total", "counter", "Time spent filtering and parsing those bytes.");
+    prom.sample("logserver_parse_seconds_total", "", t.parseMicros / 1e6);
+    if (perfCountersOn) {
+        prom.family("logserver_parse_cycles_total", "counter", "CPU cycles spent filtering and parsing.");
+        prom.sample("logserver_parse_cycles_total", "", t.parseCounters.cycles);
+        prom.family("logserver_parse_instructions_total", "counter", "Instructions retired filtering and parsing.");
+        prom.sample("logserver_parse_instructions_total", "", t.parseCounters.instructions);
+        prom.family("logserver_parse_cache_misses_total", "counter", "Last-level cache misses while filtering and parsing.");
+        prom.sample("logserver_parse_cache_misses_total", "", t.parseCounters.cacheMisses);
+        prom.family("logserver_parse_branch_misses_total", "counter", "Branch mispredictions while filtering and parsing.");
+        prom.sample("logserver_parse_branch_misses_total", "", t.parseCounters.branchMisses);
+    }
+
+    auto hists = stageStats.snapshot();
+    prom.family("logserver_stage_duration_seconds", "histogram", "Request latency per handleClient stage.");
+    for (size_t s = 0; s <= STAGE_COUNT; ++s) {
+        prom.histogram("logserver_stage_duration_seconds", string("stage=\"") + stageName(s) + "\"", *hists[s]);
+    }
+    if (ALLOC_STATS_ENABLED) {
+        vector<AllocCounts> allocs = stageStats.allocTotals();
+        prom.family("logserver_stage_allocations_total", "counter", "Heap allocations per handleClient stage.");
+        for (size_t s = 0; s <= STAGE_COUNT; ++s) {
+            prom.sample("logserver_stage_allocations_total", string("stage=\"") + stageName(s) + "\"", allocs[s].count);
+        }
+        prom.family("logserver_stage_allocated_bytes_total", "counter", "Bytes requested from operator new per handleClient stage.");
+        for (size_t s = 0; s <= STAGE_COUNT; ++s) {
+            prom.sample("logserver_stage_allocated_bytes_total", string("stage=\"") + stageName(s) + "\"", allocs[s].bytes);
+        }
+    }
+
+    prom.family("logserver_cache_hits_total", "counter", "Result cache hits.");
+    prom.sample("logserver_cache_hits_total", "", cs.hits);
+    prom.family("logserver_cache_misses_total", "counter", "Result cache misses.");
+    prom.sample("logserver_cache_misses_total", "", cs.misses);
+    prom.family("logserver_cache_hit_ratio", "gauge", "Result cache hits over lookups since start.");
+    prom.sample("logserver_cache_hit_ratio", "", cs.hitRatio());
+    prom.family("logserver_cache_bytes", "gauge", "Bytes held by the result cache.");
+    prom.sample("logserver_cache_bytes", "", cs.bytes);
+    prom.family("logserver_resident_memory_bytes", "gauge", "Resident set size of the server process.");
+    prom.sample("logserver_resident_memory_bytes", "", residentBytes());
+    return prom.str();
+}
+
+/**
+ * Admin port: answers GET /metrics with formatMetrics() and GET /trace with
+ * the recorded spans (Chrome trace-event JSON) over plain HTTP/1.0,
+ * one connection at a time on its own thread, so scrapes never compete with
+ * client connections for a handler.
+ */
+void serveAdmin(int adminSocket) {
     while (true) {
-        // find the next <log>...</log> block
-        size_t start = xmlBody.find("<log>", pos);
-        if (start == string::npos) break;
-        size_t end = xmlBody.find("</log>", start);
-        if (end == string::npos) break;
-        // include the closing tag
-        size_t blockEnd = end + strlen("</log>");
-        string logBlock = xmlBody.substr(start, blockEnd - start);
-
-        // extract timestamp and its date prefix
-        string ts = getTagValue(logBlock, "timestamp");
-        string date = ts.size() >= 10 ? ts.substr(0, 10) : "";
-
-        // apply filters
-        bool keep = true;
-        if (!fromDate.empty() && date < fromDate) keep = false;
-        if (!toDate.empty()   && date > toDate)   keep = false;
-
-        if (keep) {
-            filtered += logBlock;
-        }
-        pos = blockEnd;
-    }
-    filtered += "</logs>";
-    return filtered;
+        int sock = accept(adminSocket, nullptr, nullptr);
+        if (sock == -1) continue;
+        // A scraper that never sends its request must not stall the port
+        timeval tv{2, 0};
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        string req;
+        char buf[1024];
+        ssize_t n;
+        while (req.find("\r\n\r\n") == string::npos && req.size() < 8192 &&
+               (n = recv(sock, buf, sizeof(buf), 0)) > 0) {
+            req.append(buf, n);
+        }
+        string status = "200 OK", contentType = "text/plain; version=0.0.4", body;
+        if (req.rfind("GET /metrics ", 0) == 0 || req.rfind("GET /metrics?", 0) == 0) {
+            body = formatMetrics();
+        } else if (req.rfind("GET /trace ", 0) == 0) {
+            body        = traceRecorder.dumpJson();
+            contentType = "application/json";
+        } else {
+            status = "404 Not Found";
+            body   = "Try GET /metrics or GET /trace\n";
+        }
+        string reply = "HTTP/1.0 " + status + "\r\n"
+                       "Content-Type: " + contentType + "\r\n"
+                       "Content-Length: " + to_string(body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n" + body;
+        for (size_t sent = 0; sent < reply.size();) {
+            ssize_t w = send(sock, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+            if (w <= 0) break;
+            sent += static_cast<size_t>(w);
+        }
+        close(sock);
+    }
+}
+
+// Bind the admin port to loopback only and serve it on a detached thread
+bool startAdmin(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == -1) {
+        LOG(ERROR) << "Cannot create admin socket.";
+        return false;
+    }
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(sock, 4) == -1) {
+        LOG(ERROR) << "Admin port " << port << " unavailable.";
+        close(sock);
+        return false;
+    }
+    LOG(INFO) << "Metrics on http://127.0.0.1:" << port << "/metrics";
+    thread(serveAdmin, sock).detach();
+    return true;
+}
+
+// CMD:INGEST - convert the body to PLOGBIN once and keep it for later queries
+string ingestDataset(const string& body, bool withMessages) {
+    unique_ptr<LogParser> parser(createParser(body, "", ""));
+    if (!parser) return "[ERROR] Failed to create parser\n";
+
+    BinWriter writer(withMessages);
+    try {
+        parser->forEachRecord([&](const LogRecord& rec) { writer.add(rec); });
+    } catch (const exception& e) {
+        return string("[ERROR] Ingest failed: ") + e.what() + "\n";
+    }
+    uint64_t records = writer.recordCount();
+    string image = writer.finish();
+    size_t bytes = image.size();
+    string id = datasetStore.add(move(image), records);
+    if (id.empty()) return "[ERROR] Failed to store dataset\n";
+
+    LOG(INFO) << "Ingested dataset " << id << " (" << records << " records, "
+              << bytes << " bytes)";
+    ostringstream resp;
+    resp << "DATASET:" << id << "\n"
+         << "RECORDS:" << records << "\n"
+         << "BYTES:" << bytes << "\n";
+    return resp.str();
+}
+
+// Split a comma-separated header value, dropping empty items and spaces
+vector<string> splitList(const string& value) {
+    vector<string> items;
+    istringstream is(value);
+    string item;
+    while (getline(is, item, ',')) {
+        size_t s = item.find_first_not_of(" \t");
+        size_t e = item.find_last_not_of(" \t\r");
+        if (s != string::npos) items.push_back(item.substr(s, e - s + 1));
+    }
+    return items;
+}
+
+/**
+ * Opens a parser over stored dataset id, restricted to the date range and to
+ * LEVEL (any of) AND USER (any of) through the dataset's bitmap index, and
+ * hands it to fn. A filter on the message is refused for datasets ingested
+ * without one, rather than matching every record against an empty string.
+ * Each block is checked against its checksum the first time any query reads
+ * it; a failed block turns the response into an error.
+ * @return Empty string on success, otherwise the error response.
+ */
+string scanDataset(const string& id, const AnalysisOptions& opts,
+                   const string& fromDate, const string& toDate,
+                   const vector<string>& levels, const vector<uint32_t>& users,
+                   const function<void(BINParser&)>& fn) {
+    auto ds = datasetStore.get(id);
+    if (!ds) return "[ERROR] Unknown dataset: " + id + "\n";
+    BINParser parser(ds->data(), ds->size(), ds);
+    parser.setBlockChecks(ds->blockChecks());
+    if (opts.filter && opts.filter->usesMessage() && !parser.hasMessages()) {
+        return "[ERROR] Dataset " + id + " was ingested with MESSAGES:NO; CONTAINS/MATCH need messages\n";
+    }
+    parser.setDateRange(fromDate, toDate);
+
+    RoaringBitmap selection;
+    if (!levels.empty() || !users.empty()) {
+        auto index = ds->index();
+        if (!index) return "[ERROR] Dataset " + id + " has no usable index\n";
+        index->select(levels, users, selection);
+        parser.setSelection(&selection);
+        LOG(INFO) << "Dataset " << id << ": index selected "
+                  << selection.cardinality() << " record(s)";
+    }
+
+    fn(parser);
+    LOG(INFO) << "Dataset " << id << ": scanned " << parser.blocksScanned()
+              << " block(s), pruned " << parser.blocksSkipped();
+    if (parser.corruptBlocks() > 0) {
+        return "[ERROR] Dataset " + id + ": " + to_string(parser.corruptBlocks())
+             + " block(s) failed checksum verification\n";
+    }
+    return "";
+}
+
+// CMD:QUERY - run an analysis over a stored dataset. DISTINCT also accepts a
+// comma-separated DATASET list: one sketch per dataset, merged into one estimate.
+string queryDataset(const string& id, const AnalysisOptions& opts,
+                    const string& fromDate, const string& toDate,
+                    const vector<string>& levels, const vector<uint32_t>& users) {
+    string out;
+    if (opts.distinct) {
+        HyperLogLog merged(opts.precision);
+        for (const auto& one : splitList(id)) {
+            string err = scanDataset(one, opts, fromDate, toDate, levels, users, [&](BINParser& parser) {
+                merged.merge(distinctSketch(parser, opts));
+            });
+            if (!err.empty()) return err;
+        }
+        return formatDistinct(merged, opts.type);
+    }
+    string err = scanDataset(id, opts, fromDate, toDate, levels, users, [&](BINParser& parser) {
+        try {
+            out = runAnalysis(parser, opts);
+        } catch (const exception& e) {
+            out = string("[ERROR] Analysis failed: ") + e.what() + "\n";
+        }
+    });
+    return err.empty() ? out : err;
+}
+
+// CMD:LIST - one line per stored dataset
+string listDatasets() {
+    ostringstream resp;
+    auto all = datasetStore.list();
+    if (all.empty()) resp << "[INFO] No datasets stored.\n";
+    for (const auto& ds : all) {
+        resp << ds->id << ": " << ds->recordCount << " records, "
+             << ds->size() << " bytes\n";
+    }
+    return resp.str();
+}
+
+// Value of the last "CMD:" line of a header, as the header parser in
+// handleClient reads it ("ANALYZE" if there is none)
+string_view headerCommand(string_view header) {
+    string_view command = "ANALYZE";
+    size_t pos = 0;
+    while (pos <= header.size()) {
+        size_t eol = header.find('\n', pos);
+        if (eol == string_view::npos) eol = header.size();
+        string_view line = header.substr(pos, eol - pos);
+        if (line.substr(0, 4) == "CMD:") command = line.substr(4);
+        pos = eol + 1;
+    }
+    return command;
 }
 
 // Handle each client connection in its own thread
-void handleClient(int clientSocket) {
-    cout << "[INFO] Client connected (thread "
-              << this_thread::get_id() << ")\n";
+void handleClient(int clientSocket, StageTimer::Clock::time_point accepted) {
+    LOG(INFO) << "Client connected (thread "
+              << this_thread::get_id() << ")";
+    ServerMetrics::Connection connection(serverMetrics);
+    StageTimer timer;
+    // From accept() on the main thread to this thread running
+    traceRecorder.span("accept", accepted, timer.startTime());
 
-    // 1) Receive full request payload
+    // 1) Receive full request payload, hashing the body as it arrives so the
+    //    result cache can be consulted without a second pass over the data
     string recvBuf;
     recvBuf.reserve(BUFFER_SIZE);
     char buffer[BUFFER_SIZE];
     ssize_t n;
+    size_t hdrEnd = string::npos;
+    XXHash64 bodyHash;
+    bool tracing = traceRecorder.enabled();
+    StageTimer::Clock::time_point chunkStart = timer.startTime();
     while ((n = recv(clientSocket, buffer, sizeof(buffer), 0)) > 0) {
+        if (tracing) traceRecorder.span("recv_chunk", chunkStart, StageTimer::Clock::now(), "bytes", n);
+        size_t prevSize = recvBuf.size();
         recvBuf.append(buffer, n);
+        if (hdrEnd != string::npos) {
+            bodyHash.update(buffer, static_cast<size_t>(n));
+        } else {
+            // The separator may straddle two chunks
+            hdrEnd = recvBuf.find("\n\n", prevSize > 0 ? prevSize - 1 : 0);
+            if (hdrEnd != string::npos) {
+                // A follow session never ends its body; hand over as soon as the header is in
+                if (headerCommand(string_view(recvBuf.data(), hdrEnd)) == "FOLLOW") break;
+                bodyHash.update(recvBuf.data() + hdrEnd + 2, recvBuf.size() - hdrEnd - 2);
+            }
+        }
+        if (tracing) chunkStart = StageTimer::Clock::now();
     }
+    timer.lap(Stage::RECV);
+    serverMetrics.addBytesIn(recvBuf.size());
     if (recvBuf.empty()) {
-        cerr << "[ERROR] Empty payload\n";
+        LOG_EVERY(ERROR, 10) << "Empty payload";
         close(clientSocket);
         return;
     }
 
     // 2) Split header/body on blank line "\n\n"
-    size_t hdrEnd = recvBuf.find("\n\n");
     if (hdrEnd == string::npos) {
-        cerr << "[ERROR] Invalid payload (no header/body separator)\n";
+        LOG_EVERY(ERROR, 10) << "Invalid payload (no header/body separator)";
         close(clientSocket);
         return;
     }
     string header   = recvBuf.substr(0, hdrEnd);
     string body     = recvBuf.substr(hdrEnd + 2);
 
-    // 3) Parse header lines for analysis type and optional dates: TYPE, FROM, TO
-    string analysisStr, fromDate, toDate;
+    // 3) Parse header lines: CMD, DATASET, TYPE, FROM, TO, MESSAGES, LEVEL, USER,
+    //    FILE, OFFSET, PREFIX_HASH for APPEND, INTERVAL_MS, BATCH for FOLLOW,
+    //    BUCKET, SPLIT for TYPE:HISTOGRAM, TOP, TOP_MODE, FIELD, PRECISION
+    //    for TYPE:DISTINCT, GROUP_BY, LAYOUT, WHERE, CIDR, CONTAINS, and MATCH
+    string command = "ANALYZE", datasetId, analysisStr, fromDate, toDate, messagesOpt;
+    string levelFilter, userFilter, fileId, bucketStr = "HOUR", splitStr, topMode;
+    string fieldStr = "USER", groupByStr, layoutStr, whereStr, cidrStr;
+    string containsStr, matchStr;
+    size_t topK = 0;
+    int precision = 12;
+    uint64_t offset = 0, prefixHash = 0;
+    int intervalMs = 1000;
+    uint64_t batch = 10000;
     {
         istringstream hs(header);
         string line;
@@ -166,76 +875,301 @@ void handleClient(int clientSocket) {
                 fromDate = line.substr(5);
             } else if (line.rfind("TO:",   0) == 0) {
                 toDate   = line.substr(3);
+            } else if (line.rfind("CMD:",  0) == 0) {
+                command  = line.substr(4);
+            } else if (line.rfind("DATASET:", 0) == 0) {
+                datasetId = line.substr(8);
+            } else if (line.rfind("MESSAGES:", 0) == 0) {
+                messagesOpt = line.substr(9);
+            } else if (line.rfind("LEVEL:", 0) == 0) {
+                levelFilter = line.substr(6);
+            } else if (line.rfind("USER:",  0) == 0) {
+                userFilter  = line.substr(5);
+            } else if (line.rfind("FILE:",  0) == 0) {
+                fileId      = line.substr(5);
+            } else if (line.rfind("OFFSET:", 0) == 0) {
+                offset      = strtoull(line.c_str() + 7, nullptr, 10);
+            } else if (line.rfind("PREFIX_HASH:", 0) == 0) {
+                prefixHash  = strtoull(line.c_str() + 12, nullptr, 16);
+            } else if (line.rfind("INTERVAL_MS:", 0) == 0) {
+                intervalMs  = max(10, atoi(line.c_str() + 12));
+            } else if (line.rfind("BATCH:", 0) == 0) {
+                batch       = max<uint64_t>(1, strtoull(line.c_str() + 6, nullptr, 10));
+            } else if (line.rfind("BUCKET:", 0) == 0) {
+                bucketStr   = line.substr(7);
+            } else if (line.rfind("SPLIT:", 0) == 0) {
+                splitStr    = line.substr(6);
+            } else if (line.rfind("TOP:", 0) == 0) {
+                topK        = strtoull(line.c_str() + 4, nullptr, 10);
+            } else if (line.rfind("TOP_MODE:", 0) == 0) {
+                topMode     = line.substr(9);
+            } else if (line.rfind("FIELD:", 0) == 0) {
+                fieldStr    = line.substr(6);
+            } else if (line.rfind("PRECISION:", 0) == 0) {
+                precision   = atoi(line.c_str() + 10);
+            } else if (line.rfind("GROUP_BY:", 0) == 0) {
+                groupByStr  = line.substr(9);
+            } else if (line.rfind("LAYOUT:", 0) == 0) {
+                layoutStr   = line.substr(7);
+            } else if (line.rfind("WHERE:", 0) == 0) {
+                whereStr    = line.substr(6);
+            } else if (line.rfind("CIDR:", 0) == 0) {
+                cidrStr     = line.substr(5);
+            } else if (line.rfind("CONTAINS:", 0) == 0) {
+                containsStr = line.substr(9);
+            } else if (line.rfind("MATCH:", 0) == 0) {
+                matchStr    = line.substr(6);
             }
         }
     }
 
-    // 4) Determine AnalysisType
+    // 4) Determine AnalysisType (or the histogram options)
     AnalysisType type = AnalysisType::BY_LOG_LEVEL;
     if (analysisStr == "USER")     type = AnalysisType::BY_USER;
     else if (analysisStr == "IP")   type = AnalysisType::BY_IP;
-
-    cout << "[INFO] Analysis=" << analysisStr
-              << "  From=" << (fromDate.empty() ? "NONE" : fromDate)
-              << "  To="   << (toDate.empty()   ? "NONE" : toDate)
-              << "\n";
-
-    // 5) Auto-detect format: JSON, XML, or TXT
-    FileType ft = detectFileType(body);
-   
-    // 6) Filter body by date-range then select appropriate parser
-    LogParser* parser = nullptr;
-    switch (ft) {
-        case FileType::JSON: {
-            string filtered = filterJsonByDate(body, fromDate, toDate);
-            parser = new JSONParser(filtered);
-            break;
+    AnalysisOptions opts;
+    opts.distinct    = analysisStr == "DISTINCT";
+    if (opts.distinct) {
+        // FIELD names the counted dimension, with the same values as TYPE
+        type = fieldStr == "IP"        ? AnalysisType::BY_IP
+             : fieldStr == "LOG_LEVEL" ? AnalysisType::BY_LOG_LEVEL
+                                       : AnalysisType::BY_USER;
+    }
+    opts.precision   = max(HyperLogLog::MIN_PRECISION, min(HyperLogLog::MAX_PRECISION, precision));
+    opts.type        = type;
+    opts.histogram   = analysisStr == "HISTOGRAM";
+    opts.bucketWidth = TimeHistogram::widthFor(bucketStr);
+    opts.splitLevels = splitStr == "LOG_LEVEL";
+    opts.topK        = min(topK, MAX_TOP_K);
+    opts.topSketch   = topMode != "EXACT";
+    if (opts.histogram && opts.bucketWidth == 0) {
+        sendAll(clientSocket, "[ERROR] BUCKET must be MINUTE, HOUR or DAY\n");
+        close(clientSocket);
+        return;
+    }
+    opts.nested      = layoutStr == "NESTED";
+    if (!groupByStr.empty() && !GroupBy::parseDims(groupByStr, opts.groupBy)) {
+        sendAll(clientSocket, "[ERROR] GROUP_BY must list up to 3 of USER, IP, LOG_LEVEL\n");
+        close(clientSocket);
+        return;
+    }
+    bool hasWhere    = whereStr.find_first_not_of(" \t\r") != string::npos;
+    bool hasContains = !containsStr.empty();
+    bool hasMatch    = !matchStr.empty();
+    if (hasWhere || hasContains || hasMatch) {
+        auto filter = make_shared<RecordFilter>();
+        string err;
+        if (hasWhere && !filter->compile(whereStr, err)) {
+            sendAll(clientSocket, "[ERROR] Invalid WHERE: " + err + "\n");
+            close(clientSocket);
+            return;
+        }
+        // CONTAINS:a,b is shorthand for AND message CONTAINS ('a','b')
+        if (hasContains && !filter->addContains(splitList(containsStr), err)) {
+            sendAll(clientSocket, "[ERROR] Invalid CONTAINS: " + err + "\n");
+            close(clientSocket);
+            return;
         }
-        case FileType::TXT: {
-            string filtered = filterTxtByDate(body, fromDate, toDate);
-            parser = new TXTParser(filtered);
-            break;
+        // MATCH:regex is shorthand for AND message MATCHES 'regex'
+        if (hasMatch && !filter->addMatch(matchStr, err)) {
+            sendAll(clientSocket, "[ERROR] Invalid MATCH: " + err + "\n");
+            close(clientSocket);
+            return;
         }
-        case FileType::XML: {
-            string filtered = filterXmlByDate(body, fromDate, toDate);
-            parser = new XMLParser(filtered);
-            break;
+        opts.filter    = filter;
+        opts.whereText = whereStr + "|CONTAINS " + containsStr + "|MATCH " + matchStr;
+    }
+    if (!cidrStr.empty()) {
+        string cidrErr;
+        if (cidrStr.find_first_not_of("0123456789") == string::npos) {
+            opts.cidrBits = cidrStr.size() <= 2 ? stoi(cidrStr) : 99;
+            if (opts.cidrBits > 32) cidrErr = "prefix length must be 0-32";
+        } else {
+            // name=block or a bare block named after itself
+            auto table = make_shared<CidrTable>();
+            for (const auto& item : splitList(cidrStr)) {
+                size_t eq = item.find('=');
+                string name  = eq == string::npos ? item : item.substr(0, eq);
+                string block = eq == string::npos ? item : item.substr(eq + 1);
+                if (!table->add(name, block)) cidrErr = "invalid block '" + block + "'";
+            }
+            table->build();
+            opts.cidrTable = table;
+        }
+        if (!cidrErr.empty()) {
+            sendAll(clientSocket, "[ERROR] Invalid CIDR: " + cidrErr + "\n");
+            close(clientSocket);
+            return;
         }
+        opts.cidrText = cidrStr;
     }
+    timer.lap(Stage::HEADER);
 
-    if (!parser) {
-        cerr << "[ERROR] Failed to create parser\n";
+    size_t commandLabel = metricLabelIndex(METRIC_COMMANDS, command);
+    size_t formatLabel  = body.empty() ? METRIC_FORMAT_COUNT - 1
+                                       : static_cast<size_t>(detectFileType(body));
+    size_t typeLabel    = METRIC_TYPE_COUNT - 1;
+    if (command == "ANALYZE" || command == "QUERY" || command == "APPEND" || command == "FOLLOW") {
+        typeLabel = metricLabelIndex(METRIC_TYPES, analysisStr.empty() ? "LOG_LEVEL" : analysisStr);
+    }
+
+    string out;
+    if (command == "INGEST") {
+        out = ingestDataset(body, messagesOpt != "NO");
+    } else if (command == "QUERY") {
+        LOG(INFO) << "Query dataset=" << datasetId << "  Analysis=" << analysisStr
+                  << "  From=" << (fromDate.empty() ? "NONE" : fromDate)
+                  << "  To="   << (toDate.empty()   ? "NONE" : toDate);
+        vector<uint32_t> users;
+        bool usersOk = true;
+        for (const auto& u : splitList(userFilter)) {
+            uint32_t id;
+            if (parseUserId(u, id)) users.push_back(id);
+            else usersOk = false;
+        }
+        out = usersOk ? queryDataset(datasetId, opts, fromDate, toDate, splitList(levelFilter), users)
+                      : "[ERROR] USER filter must be a list of numeric ids\n";
+    } else if (command == "LIST") {
+        out = listDatasets();
+    } else if (command == "DROP") {
+        out = datasetStore.remove(datasetId)
+                  ? "[INFO] Dropped dataset " + datasetId + "\n"
+                  : "[ERROR] Unknown dataset: " + datasetId + "\n";
+    } else if (command == "APPEND") {
+        out = appendIncremental(fileId, type, fromDate, toDate, offset, prefixHash, body);
+    } else if (command == "STATS") {
+        out = formatStats();
+    } else if (command == "TRACE") {
+        out = traceRecorder.enabled() ? traceRecorder.dumpJson()
+                                      : "[ERROR] Tracing is off (start the server with --trace-events N)\n";
+    } else if (command == "FOLLOW") {
+        LOG(INFO) << "Follow session: Analysis=" << analysisStr
+                  << "  interval=" << intervalMs << "ms  batch=" << batch;
+        serverMetrics.countRequest(commandLabel, formatLabel, typeLabel);
+        followStream(clientSocket, type, fromDate, toDate, intervalMs, batch, body);
         close(clientSocket);
         return;
-    }
+    } else {
+        LOG(INFO) << "Analysis=" << analysisStr
+                  << "  From=" << (fromDate.empty() ? "NONE" : fromDate)
+                  << "  To="   << (toDate.empty()   ? "NONE" : toDate);
+
+        // 5) Identical body + normalized header => identical result
+        ostringstream key;
+        key << hex << bodyHash.digest() << dec << ':' << body.size()
+            << '|' << opts.cacheKey() << '|' << fromDate << '|' << toDate;
+        string cacheKey = key.str();
 
-    // 7) Parse and get results
-    auto result = parser->parse(type);
-    delete parser;
+        bool cached = resultCache.get(cacheKey, out);
+        timer.lap(Stage::CACHE);
+        if (cached) {
+            LOG(INFO) << "Result cache hit";
+        } else {
+            // 6) Auto-detect format, filter body by date-range and select the parser
+            PerfCounters* perf = threadPerfCounters();
+            if (perf) perf->start();
+            LogParser* parser = createParser(body, fromDate, toDate);
+            timer.lap(Stage::FILTER);
+            if (!parser) {
+                LOG_EVERY(ERROR, 10) << "Failed to create parser";
+                close(clientSocket);
+                return;
+            }
+
+            // 7) Parse and get results (a failed analysis is not cached)
+            try {
+                out = runAnalysis(*parser, opts);
+                resultCache.put(cacheKey, out);
+            } catch (const exception& e) {
+                LOG_EVERY(ERROR, 10) << "Analysis failed: " << e.what();
+                out = string("[ERROR] Analysis failed: ") + e.what() + "\n";
+            }
+            delete parser;
+            timer.lap(Stage::PARSE);
+            serverMetrics.addParse(body.size(), timer.stageMicros(static_cast<size_t>(Stage::FILTER)) +
+                                                timer.stageMicros(static_cast<size_t>(Stage::PARSE)));
+            if (perf) serverMetrics.addParseCounters(perf->stop());
+        }
+    }
+    // Commands other than ANALYZE charge their work to the parse stage
+    if (!timer.stageRan(static_cast<size_t>(Stage::CACHE))) timer.lap(Stage::PARSE);
 
     // 8) Send results back to client
-    ostringstream resp;
-    if (result.empty()) {
-        resp << "[INFO] No entries matched your query.\n";
-    } else {
-        for (const auto& pair : result) {
-            resp << pair.first << ": ";
-            resp << pair.second << "\n";
-         }
+    sendAll(clientSocket, out);
+    timer.lap(Stage::SEND);
+
+    // 9) Record stage latencies and request counters; log the breakdown of slow requests
+    stageStats.record(timer);
+    serverMetrics.countRequest(commandLabel, formatLabel, typeLabel);
+    traceRecorder.stages(timer, METRIC_COMMANDS[commandLabel], METRIC_TYPES[typeLabel], body.size());
+    if (slowRequestMs && timer.totalMicros() >= slowRequestMs * 1000) {
+        LOG_EVERY(WARN, 10) << "Slow request " << timer.totalMicros() / 1000.0 << "ms (CMD=" << command
+                  << " TYPE=" << (analysisStr.empty() ? "LOG_LEVEL" : analysisStr)
+                  << " body=" << body.size() << " bytes): " << timer.breakdown()
+                  << (ALLOC_STATS_ENABLED ? " | allocs: " + timer.allocBreakdown() : "");
     }
-    string out = resp.str();
-    send(clientSocket, out.c_str(), out.size(), 0);
 
-    cout << "[INFO] Done, closing connection\n";
+    LOG(INFO) << "Done, closing connection";
     close(clientSocket);
 }
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Command-line options: --data-dir DIR | --in-memory, --cache-mb N, --slow-ms N,
+    // --admin-port N, --log-level debug|info|warn|error, --trace-events N, --perf-counters
+    string dataDir = "data";
+    int adminPort = 0;
+    for (int i = 1; i < argc; ++i) {
+        string opt = argv[i];
+        if (opt == "--data-dir" && i + 1 < argc) {
+            dataDir = argv[++i];
+        } else if (opt == "--in-memory") {
+            dataDir.clear();
+        } else if (opt == "--cache-mb" && i + 1 < argc) {
+            resultCache.setCapacity(stoull(argv[++i]) << 20);
+        } else if (opt == "--slow-ms" && i + 1 < argc) {
+            slowRequestMs = stoull(argv[++i]);
+        } else if (opt == "--admin-port" && i + 1 < argc) {
+            adminPort = stoi(argv[++i]);
+        } else if (opt == "--perf-counters") {
+            perfCountersOn = true;
+        } else if (opt == "--trace-events" && i + 1 < argc) {
+            traceRecorder.enable(stoull(argv[++i]));
+        } else if (opt == "--log-level" && i + 1 < argc) {
+            LogLevel level;
+            if (!parseLogLevel(argv[++i], level)) {
+                cerr << "[ERROR] --log-level must be debug, info, warn or error\n";
+                return 1;
+            }
+            asyncLogger.setLevel(level);
+        } else {
+            cerr << "Usage: " << argv[0]
+                 << " [--data-dir DIR | --in-memory] [--cache-mb N] [--slow-ms N] [--admin-port N]\n"
+                 << "       [--log-level debug|info|warn|error] [--trace-events N]\n"
+                 << "       [--perf-counters]\n";
+            return 1;
+        }
+    }
+
+    // Probe once so a box without a usable PMU says so up front
+    if (perfCountersOn) {
+        PerfCounters probe;
+        string err;
+        if (!probe.open(err)) {
+            LOG(WARN) << "--perf-counters: hardware counters unavailable (" << err << "), disabled";
+            perfCountersOn = false;
+        }
+    }
+
+    // Map previously ingested datasets before accepting clients
+    if (!dataDir.empty() && !datasetStore.open(dataDir)) {
+        return 1;
+    }
+
     // Create listening TCP socket
     int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
     if (serverSocket == -1) {
-        cerr << "[ERROR] Cannot create socket.\n";
+        LOG(ERROR) << "Cannot create socket.";
         return 1;
     }
 
@@ -246,16 +1180,22 @@ int main() {
     serverAddr.sin_addr.s_addr = INADDR_ANY;
 
     if (bind(serverSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) == -1) {
-        cerr << "[ERROR] Bind failed.\n";
+        LOG(ERROR) << "Bind failed.";
         return 1;
     }
 
     // Start listening for connections
     if (listen(serverSocket, 10) == -1) {
-        cerr << "[ERROR] Listen failed.\n";
+        LOG(ERROR) << "Listen failed.";
+        return 1;
+    }
+    LOG(INFO) << "Server listening on port " << PORT << "...";
+    listenSocket = serverSocket;
+
+    // Optional Prometheus metrics page on a loopback-only port
+    if (adminPort > 0 && !startAdmin(adminPort)) {
         return 1;
     }
-    cout << "[INFO] Server listening on port " << PORT << "...\n";
 
     // Main accept loop: spawn a detached thread per client
     while (true) {
@@ -265,11 +1205,11 @@ int main() {
                                   (struct sockaddr*)&clientAddr,
                                   &clientLen);
         if (clientSocket == -1) {
-            cerr << "[ERROR] Accept failed.\n";
+            LOG(ERROR) << "Accept failed.";
             continue;
         }
         // create a new thread
-        thread t(handleClient, clientSocket);
+        thread t(handleClient, clientSocket, StageTimer::Clock::now());
         t.detach();
     }
 
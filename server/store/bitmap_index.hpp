@@ -0,0 +1,138 @@
+// File: server/store/bitmap_index.hpp
+// BitmapIndex: Per-level and per-user RoaringBitmaps of record positions in a
+// stored dataset, used to answer LEVEL/USER filtered queries without a full scan.
+
+#ifndef BITMAP_INDEX_HPP
+#define BITMAP_INDEX_HPP
+
+#include "../util/roaring_bitmap.hpp"
+#include "../parser/bin_format.hpp"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Record positions are the global record numbers of a PLOGBIN image
+ * (BlockInfo::firstRecord + row), so a selection maps straight onto blocks.
+ */
+class BitmapIndex {
+public:
+    /**
+     * Builds the index in one pass over the level and user columns of an image.
+     * @return false if the image is invalid.
+     */
+    bool build(const char* data, size_t size) {
+        BinView view;
+        if (!view.open(data, size)) return false;
+        levelBitmaps.clear();
+        userBitmaps.clear();
+
+        vector<RoaringBitmap*> byLevelIdx(view.levels().size(), nullptr);
+        for (size_t i = 0; i < view.levels().size(); ++i) {
+            byLevelIdx[i] = &levelBitmaps[string(view.levels()[i])];
+        }
+        vector<uint32_t> users;
+        for (uint32_t b = 0; b < view.blockCount(); ++b) {
+            BinBlock blk;
+            if (!view.columns(view.block(b), blk)) return false;
+            blk.decodeUsers(users);
+            uint32_t base = static_cast<uint32_t>(blk.info.firstRecord);
+            for (uint32_t r = 0; r < blk.info.recordCount; ++r) {
+                uint8_t lv = blk.levels[r];
+                if (lv < byLevelIdx.size()) byLevelIdx[lv]->add(base + r);
+                userBitmaps[users[r]].add(base + r);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Positions matching (any of levels) AND (any of users).
+     * An empty list leaves that dimension unconstrained; both empty means
+     * "no filter" and is reported by returning false.
+     */
+    bool select(const vector<string>& levels, const vector<uint32_t>& users,
+                RoaringBitmap& out) const {
+        if (levels.empty() && users.empty()) return false;
+        RoaringBitmap levelSel, userSel;
+        for (const auto& name : levels) {
+            auto it = levelBitmaps.find(name);
+            if (it != levelBitmaps.end()) levelSel = RoaringBitmap::orOf(levelSel, it->second);
+        }
+        for (uint32_t user : users) {
+            auto it = userBitmaps.find(user);
+            if (it != userBitmaps.end()) userSel = RoaringBitmap::orOf(userSel, it->second);
+        }
+        if (levels.empty())     out = move(userSel);
+        else if (users.empty()) out = move(levelSel);
+        else                    out = RoaringBitmap::andOf(levelSel, userSel);
+        return true;
+    }
+
+    // Approximate heap footprint in bytes
+    size_t memoryBytes() const {
+        size_t n = 0;
+        for (const auto& kv : levelBitmaps) n += kv.first.size() + kv.second.memoryBytes();
+        for (const auto& kv : userBitmaps)  n += sizeof(kv.first) + kv.second.memoryBytes();
+        return n;
+    }
+
+    /**
+     * Serialised form: uint32 levelCount, then (uint8 nameLen, name, bitmap)*,
+     * uint32 userCount, then (uint32 userId, bitmap)*.
+     */
+    string serialize() const {
+        string out;
+        uint32_t n = static_cast<uint32_t>(levelBitmaps.size());
+        out.append(reinterpret_cast<const char*>(&n), sizeof(n));
+        for (const auto& kv : levelBitmaps) {
+            out.push_back(static_cast<char>(kv.first.size()));
+            out += kv.first;
+            kv.second.serialize(out);
+        }
+        n = static_cast<uint32_t>(userBitmaps.size());
+        out.append(reinterpret_cast<const char*>(&n), sizeof(n));
+        for (const auto& kv : userBitmaps) {
+            out.append(reinterpret_cast<const char*>(&kv.first), sizeof(kv.first));
+            kv.second.serialize(out);
+        }
+        return out;
+    }
+
+    // Reads the form written by serialize(); returns false on malformed input
+    bool deserialize(const char* data, size_t size) {
+        levelBitmaps.clear();
+        userBitmaps.clear();
+        const uint8_t* p   = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        auto getU32 = [&](uint32_t& v) {
+            if (end - p < 4) return false;
+            memcpy(&v, p, 4);
+            p += 4;
+            return true;
+        };
+        uint32_t n;
+        if (!getU32(n)) return false;
+        for (uint32_t i = 0; i < n; ++i) {
+            if (p >= end || end - p - 1 < *p) return false;
+            string name(reinterpret_cast<const char*>(p + 1), *p);
+            p += 1 + name.size();
+            if (!levelBitmaps[name].deserialize(p, end)) return false;
+        }
+        if (!getU32(n)) return false;
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t user;
+            if (!getU32(user) || !userBitmaps[user].deserialize(p, end)) return false;
+        }
+        return p == end;
+    }
+
+private:
+    map<string, RoaringBitmap> levelBitmaps;              ///< Level name -> positions
+    unordered_map<uint32_t, RoaringBitmap> userBitmaps;   ///< User id -> positions
+};
+
+#endif // BITMAP_INDEX_HPP
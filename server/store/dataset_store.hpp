@@ -0,0 +1,268 @@
+// File: server/store/dataset_store.hpp
+// DatasetStore: Keeps ingested logs on the server in PLOGBIN form so they can be
+// queried repeatedly without being uploaded again.
+
+#ifndef DATASET_STORE_HPP
+#define DATASET_STORE_HPP
+
+#include "segment_file.hpp"
+#include "bitmap_index.hpp"
+#include "../parser/mapped_file.hpp"
+#include "../util/async_logger.hpp"
+#include "../util/xxhash64.hpp"
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * One ingested log file, immutable once stored.
+ * The PLOGBIN image lives either in memory (no data directory) or in a
+ * memory-mapped segment file, in which case pages are read on demand.
+ */
+struct Dataset {
+    string   id;            ///< Identifier returned to the client ("ds-<n>")
+    uint64_t recordCount = 0;
+
+    const char* data() const { return imageData; }
+    size_t size() const { return imageSize; }
+
+    /**
+     * Checks the whole-payload checksum the first time it is called (later
+     * calls return the cached answer). In-memory datasets are always intact.
+     * This reads the entire image, so it runs in the background after
+     * startup; queries rely on the per-block checks (blockChecks()).
+     */
+    bool verify() const {
+        call_once(verifyOnce, [this] {
+            intact = expectedChecksum == 0 ||
+                     XXHash64::hash(imageData, imageSize) == expectedChecksum;
+        });
+        return intact;
+    }
+
+    /**
+     * Per-block checksum state for BINParser::setBlockChecks, shared by all
+     * queries so each block is hashed once, by the first query that reads it.
+     */
+    atomic<uint8_t>* blockChecks() const {
+        call_once(checksOnce, [this] {
+            BinHeader h{};
+            if (imageSize >= sizeof(h)) memcpy(&h, imageData, sizeof(h));
+            checks.reset(new atomic<uint8_t>[h.blockCount]());
+        });
+        return checks.get();
+    }
+
+    /**
+     * Level/user bitmap index. Built at ingest; for datasets mapped at startup
+     * it is loaded from "<id>.idx" on first use, or rebuilt from the image if
+     * that file is missing or damaged. Returns nullptr only for invalid images.
+     */
+    shared_ptr<const BitmapIndex> index() const {
+        call_once(indexOnce, [this] {
+            if (loadedIndex) return;
+            auto idx = make_shared<BitmapIndex>();
+            MappedFile idxFile;
+            SegmentHeader h;
+            string err;
+            if (!indexPath.empty() && idxFile.open(indexPath) &&
+                readSegmentHeader(idxFile.data(), idxFile.size(), h, err) &&
+                XXHash64::hash(idxFile.data() + h.headerSize, h.payloadSize) == h.payloadChecksum &&
+                idx->deserialize(idxFile.data() + h.headerSize, h.payloadSize)) {
+                loadedIndex = idx;
+                return;
+            }
+            if (!indexPath.empty()) {
+                LOG(WARN) << "Rebuilding bitmap index for " << id;
+            }
+            if (idx->build(imageData, imageSize)) loadedIndex = idx;
+        });
+        return loadedIndex;
+    }
+
+    string     image;       ///< Backing bytes for in-memory datasets
+    MappedFile file;        ///< Backing mapping for persisted datasets
+    string     path;        ///< Segment path ("" when not persisted)
+    string     indexPath;   ///< Bitmap index path ("" when not persisted)
+    const char* imageData = nullptr;
+    size_t      imageSize = 0;
+    uint64_t    expectedChecksum = 0;  ///< Payload checksum from the segment header (0 = none)
+    mutable shared_ptr<const BitmapIndex> loadedIndex;
+
+private:
+    mutable once_flag verifyOnce;
+    mutable once_flag indexOnce;
+    mutable once_flag checksOnce;
+    mutable bool intact = false;
+    mutable unique_ptr<atomic<uint8_t>[]> checks;  ///< One state per block, see blockChecks()
+};
+
+/**
+ * Thread-safe registry of ingested datasets.
+ * With a data directory, every dataset is written as an immutable segment file
+ * ("<dir>/ds-<n>.seg", plus its bitmap index in "<dir>/ds-<n>.idx") and
+ * served from an mmap of that file; on startup the
+ * directory is scanned and every valid segment is mapped without reading it.
+ * Readers receive a shared_ptr, so a dataset dropped while a query is running
+ * stays alive until that query finishes.
+ */
+class DatasetStore {
+public:
+    /**
+     * Enables persistence under dataDir and maps any segments already there.
+     * @return false if the directory cannot be created.
+     */
+    bool open(const string& dataDir) {
+        namespace fs = filesystem;
+        error_code ec;
+        fs::create_directories(dataDir, ec);
+        if (ec) {
+            LOG(ERROR) << "Cannot create data directory " << dataDir << ": " << ec.message();
+            return false;
+        }
+        dir = dataDir;
+
+        size_t loaded = 0;
+        uint64_t bytes = 0;
+        for (const auto& entry : fs::directory_iterator(dir, ec)) {
+            string name = entry.path().filename().string();
+            // Leftovers from an interrupted ingest
+            if (entry.path().extension() == ".tmp") {
+                fs::remove(entry.path(), ec);
+                continue;
+            }
+            if (entry.path().extension() != ".seg" || name.rfind("ds-", 0) != 0) continue;
+
+            auto ds = make_shared<Dataset>();
+            ds->id = entry.path().stem().string();
+            string err;
+            if (!mapSegment(entry.path().string(), *ds, err)) {
+                LOG(WARN) << "Skipping segment " << name << ": " << err;
+                continue;
+            }
+            uint64_t num = strtoull(ds->id.c_str() + 3, nullptr, 10);
+            if (num >= nextId) nextId = num + 1;
+            bytes += ds->size();
+            ++loaded;
+
+            lock_guard<mutex> lock(mtx);
+            datasets[ds->id] = ds;
+        }
+        LOG(INFO) << "Loaded " << loaded << " dataset(s) (" << bytes
+                  << " bytes mapped) from " << dir;
+
+        // Whole-segment checksums are checked off the request path
+        thread([all = list()] {
+            for (const auto& ds : all) {
+                if (!ds->verify()) {
+                    LOG(WARN) << "Dataset " << ds->id << " failed checksum verification";
+                }
+            }
+        }).detach();
+        return true;
+    }
+
+    /**
+     * Stores a converted image and assigns it a new id. When persistence is
+     * enabled the image is written to a segment and the in-memory copy released.
+     * @return The id clients use in later QUERY requests, or "" if persisting failed.
+     */
+    string add(string image, uint64_t recordCount) {
+        auto ds = make_shared<Dataset>();
+        ds->id = "ds-" + to_string(nextId.fetch_add(1));
+        ds->recordCount = recordCount;
+
+        auto idx = make_shared<BitmapIndex>();
+        if (!idx->build(image.data(), image.size())) {
+            LOG(ERROR) << "Cannot index dataset " << ds->id;
+            return "";
+        }
+        ds->loadedIndex = idx;
+
+        if (dir.empty()) {
+            ds->image = move(image);
+            ds->imageData = ds->image.data();
+            ds->imageSize = ds->image.size();
+        } else {
+            string path = dir + "/" + ds->id + ".seg";
+            string err;
+            // The index is written first so a visible segment always has one
+            if (!writeSegment(dir + "/" + ds->id + ".idx", idx->serialize(), recordCount, err) ||
+                !writeSegment(path, image, recordCount, err) || !mapSegment(path, *ds, err)) {
+                LOG(ERROR) << "Cannot persist dataset " << ds->id << ": " << err;
+                return "";
+            }
+        }
+
+        lock_guard<mutex> lock(mtx);
+        datasets[ds->id] = ds;
+        return ds->id;
+    }
+
+    // Returns the dataset or nullptr if the id is unknown
+    shared_ptr<const Dataset> get(const string& id) const {
+        lock_guard<mutex> lock(mtx);
+        auto it = datasets.find(id);
+        return it == datasets.end() ? nullptr : it->second;
+    }
+
+    // Removes a dataset (and its segment file); returns false if the id is unknown
+    bool remove(const string& id) {
+        shared_ptr<const Dataset> ds;
+        {
+            lock_guard<mutex> lock(mtx);
+            auto it = datasets.find(id);
+            if (it == datasets.end()) return false;
+            ds = it->second;
+            datasets.erase(it);
+        }
+        // Running queries keep their mapping; the inode is freed when they finish
+        if (!ds->path.empty()) {
+            unlink(ds->path.c_str());
+            unlink(ds->indexPath.c_str());
+        }
+        return true;
+    }
+
+    // Snapshot of all datasets currently stored
+    vector<shared_ptr<const Dataset>> list() const {
+        lock_guard<mutex> lock(mtx);
+        vector<shared_ptr<const Dataset>> out;
+        out.reserve(datasets.size());
+        for (const auto& kv : datasets) out.push_back(kv.second);
+        return out;
+    }
+
+private:
+    // Maps a segment and points the dataset at its payload
+    static bool mapSegment(const string& path, Dataset& ds, string& err) {
+        if (!ds.file.open(path)) {
+            err = "cannot map file";
+            return false;
+        }
+        SegmentHeader h;
+        if (!readSegmentHeader(ds.file.data(), ds.file.size(), h, err)) return false;
+        ds.path             = path;
+        ds.indexPath        = path.substr(0, path.size() - 4) + ".idx";
+        ds.recordCount      = h.recordCount;
+        ds.imageData        = ds.file.data() + h.headerSize;
+        ds.imageSize        = h.payloadSize;
+        ds.expectedChecksum = h.payloadChecksum;
+        return true;
+    }
+
+    mutable mutex mtx;
+    unordered_map<string, shared_ptr<const Dataset>> datasets;
+    atomic<uint64_t> nextId{1};
+    string dir;  ///< Data directory ("" = in-memory only)
+};
+
+#endif // DATASET_STORE_HPP
@@ -0,0 +1,132 @@
+// File: server/store/segment_file.hpp
+// Segment files: immutable, checksummed on-disk containers for ingested PLOGBIN images.
+
+#ifndef SEGMENT_FILE_HPP
+#define SEGMENT_FILE_HPP
+
+#include "../util/xxhash64.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ * Segment layout:
+ *
+ *   SegmentHeader   64 bytes
+ *   payload         PLOGBIN image (starts 8-aligned, so its columns stay aligned when mapped)
+ *
+ * headerChecksum covers the header fields before it and is checked when the
+ * segment is opened. payloadChecksum covers the whole payload; it is checked
+ * lazily on first use so that startup only touches the first page of each file.
+ */
+
+constexpr char     SEGMENT_MAGIC[8] = {'P', 'L', 'O', 'G', 'S', 'E', 'G', '1'};
+constexpr uint32_t SEGMENT_VERSION  = 1;
+
+struct SegmentHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t payloadSize;
+    uint64_t recordCount;
+    uint64_t payloadChecksum;
+    uint64_t createdAt;        ///< Unix time the segment was written
+    uint64_t reserved;
+    uint64_t headerChecksum;
+};
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader must stay 64 bytes");
+
+inline uint64_t segmentHeaderChecksum(const SegmentHeader& h) {
+    return XXHash64::hash(&h, offsetof(SegmentHeader, headerChecksum));
+}
+
+/**
+ * Writes a segment atomically: data goes to "<path>.tmp", is fsync'd, made
+ * read-only and then renamed into place, so a crash never leaves a partial
+ * segment under the final name.
+ *
+ * @return false with err set on any I/O failure.
+ */
+inline bool writeSegment(const string& path, const string& payload,
+                         uint64_t recordCount, string& err) {
+    SegmentHeader h{};
+    memcpy(h.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    h.version         = SEGMENT_VERSION;
+    h.headerSize      = sizeof(SegmentHeader);
+    h.payloadSize     = payload.size();
+    h.recordCount     = recordCount;
+    h.payloadChecksum = XXHash64::hash(payload.data(), payload.size());
+    h.createdAt       = static_cast<uint64_t>(time(nullptr));
+    h.headerChecksum  = segmentHeaderChecksum(h);
+
+    string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        err = "cannot create " + tmp + ": " + strerror(errno);
+        return false;
+    }
+    auto writeAll = [&](const char* p, size_t len) {
+        while (len > 0) {
+            ssize_t n = ::write(fd, p, len);
+            if (n <= 0) return false;
+            p   += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    };
+    bool ok = writeAll(reinterpret_cast<const char*>(&h), sizeof(h)) &&
+              writeAll(payload.data(), payload.size()) &&
+              fsync(fd) == 0;
+    ::close(fd);
+    if (!ok) {
+        err = "write failed for " + tmp + ": " + strerror(errno);
+        unlink(tmp.c_str());
+        return false;
+    }
+    chmod(tmp.c_str(), 0444);
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        err = "rename failed for " + path + ": " + strerror(errno);
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Validates the header of a mapped segment.
+ * @return false with err set if the header is missing, corrupt or inconsistent with size.
+ */
+inline bool readSegmentHeader(const char* data, size_t size, SegmentHeader& h, string& err) {
+    if (size < sizeof(SegmentHeader)) {
+        err = "file too small";
+        return false;
+    }
+    memcpy(&h, data, sizeof(h));
+    if (memcmp(h.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0) {
+        err = "bad magic";
+        return false;
+    }
+    if (h.headerChecksum != segmentHeaderChecksum(h)) {
+        err = "header checksum mismatch";
+        return false;
+    }
+    if (h.version != SEGMENT_VERSION || h.headerSize != sizeof(SegmentHeader)) {
+        err = "unsupported segment version";
+        return false;
+    }
+    if (h.headerSize + h.payloadSize != size) {
+        err = "size mismatch (truncated segment)";
+        return false;
+    }
+    return true;
+}
+
+#endif // SEGMENT_FILE_HPP
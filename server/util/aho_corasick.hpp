@@ -0,0 +1,120 @@
+// File: server/util/aho_corasick.hpp
+// AhoCorasick: Single-pass matcher for "text contains any of these literals".
+
+#ifndef AHO_CORASICK_HPP
+#define AHO_CORASICK_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Aho-Corasick automaton compiled into a dense DFA: every state has a
+ * transition for every byte class, so scanning is one table lookup per byte
+ * with no failure-link walks. Bytes that occur in no pattern share class 0,
+ * which keeps the table at states x (distinct pattern bytes + 1) entries.
+ *
+ * While in the start state the scanner skips ahead over bytes that cannot
+ * begin a pattern, so text without candidate bytes is passed over in a tight
+ * loop without touching the table.
+ */
+class AhoCorasick {
+public:
+    static constexpr size_t MAX_PATTERN_BYTES = 8192;  ///< Bounds the DFA to a few MB
+
+    /**
+     * Compiles the patterns.
+     * @return false if there are none, one is empty, or together they exceed
+     *         MAX_PATTERN_BYTES.
+     */
+    bool build(const vector<string>& patterns) {
+        size_t totalBytes = 0;
+        for (const auto& p : patterns) {
+            if (p.empty()) return false;
+            totalBytes += p.size();
+        }
+        if (patterns.empty() || totalBytes > MAX_PATTERN_BYTES) return false;
+
+        // Byte classes: one per distinct pattern byte, 0 for everything else
+        for (auto& c : classOf) c = 0;
+        classes = 1;
+        for (const auto& p : patterns) {
+            for (unsigned char b : p) {
+                if (classOf[b] == 0) classOf[b] = static_cast<uint16_t>(classes++);
+            }
+        }
+
+        // Trie of the patterns; -1 marks a missing edge
+        trans.assign(classes, -1);
+        accepting.assign(1, 0);
+        for (const auto& p : patterns) {
+            int32_t s = 0;
+            for (unsigned char b : p) {
+                int32_t& next = trans[s * classes + classOf[b]];
+                if (next < 0) {
+                    next = static_cast<int32_t>(accepting.size());
+                    accepting.push_back(0);
+                    trans.resize(trans.size() + classes, -1);
+                }
+                s = trans[s * classes + classOf[b]];  // trans may have been reallocated
+            }
+            accepting[s] = 1;
+        }
+
+        // Breadth-first: fill missing edges through the failure links
+        vector<int32_t> fail(accepting.size(), 0), queue;
+        queue.reserve(accepting.size());
+        for (size_t c = 0; c < classes; ++c) {
+            int32_t& t = trans[c];
+            if (t < 0) t = 0;
+            else       queue.push_back(t);
+        }
+        for (size_t qi = 0; qi < queue.size(); ++qi) {
+            int32_t s = queue[qi];
+            accepting[s] |= accepting[fail[s]];
+            for (size_t c = 0; c < classes; ++c) {
+                int32_t& t = trans[s * classes + c];
+                int32_t viaFail = trans[fail[s] * classes + c];
+                if (t < 0) {
+                    t = viaFail;
+                } else {
+                    fail[t] = viaFail;
+                    queue.push_back(t);
+                }
+            }
+        }
+
+        for (int b = 0; b < 256; ++b) startByte[b] = trans[classOf[b]] != 0;
+        return true;
+    }
+
+    // True if text contains at least one of the patterns
+    bool containsAny(string_view text) const {
+        const unsigned char* p   = reinterpret_cast<const unsigned char*>(text.data());
+        const unsigned char* end = p + text.size();
+        int32_t s = 0;
+        while (p < end) {
+            if (s == 0) {
+                while (p < end && !startByte[*p]) ++p;
+                if (p == end) break;
+            }
+            s = trans[s * classes + classOf[*p++]];
+            if (accepting[s]) return true;
+        }
+        return false;
+    }
+
+    size_t stateCount() const { return accepting.size(); }
+
+private:
+    uint16_t        classOf[256] = {};   ///< Byte -> class
+    bool            startByte[256] = {}; ///< Bytes that leave the start state
+    size_t          classes = 1;
+    vector<int32_t> trans;               ///< [state * classes + class] -> state
+    vector<uint8_t> accepting;           ///< State ends (a suffix equal to) a pattern
+};
+
+#endif // AHO_CORASICK_HPP
@@ -0,0 +1,373 @@
+// File: server/util/async_logger.hpp
+// AsyncLogger: Per-thread lock-free log rings drained by a background flusher.
+
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+enum class LogLevel { DEBUG, INFO, WARN, ERROR };
+
+inline const char* logLevelTag(LogLevel level) {
+    static const char* tags[] = {"[DEBUG] ", "[INFO] ", "[WARN] ", "[ERROR] "};
+    return tags[static_cast<int>(level)];
+}
+
+// "debug", "info", "warn" or "error" (any case)
+inline bool parseLogLevel(string name, LogLevel& out) {
+    transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return toupper(c); });
+    static const char* names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+    for (int i = 0; i < 4; ++i) {
+        if (name == names[i]) {
+            out = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+class LogTally;
+
+/**
+ * Log lines are formatted by the calling thread and copied into that
+ * thread's ring buffer (single producer, single consumer: no lock, no
+ * syscall). A background thread drains every ring every FLUSH_MS, or sooner
+ * when a ring passes half full, and writes INFO/DEBUG to stdout and
+ * WARN/ERROR to stderr in one write per stream. A full ring drops the line
+ * and the drop is reported by the flusher; logging never blocks a request.
+ *
+ * Lines from one thread keep their order; lines from different threads are
+ * ordered only to within a flush interval. The flusher starts with the
+ * first line; destruction (at exit) drains everything still buffered.
+ */
+class AsyncLogger {
+public:
+    static constexpr size_t RING_BYTES = 1 << 16;  ///< Per thread
+    static constexpr size_t MAX_LINE   = 4096;     ///< Longer lines are truncated
+    static constexpr int    FLUSH_MS   = 50;
+
+    ~AsyncLogger() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (flusher.joinable()) flusher.join();
+        drain(true);
+    }
+
+    void setLevel(LogLevel level) { minLevel.store(static_cast<int>(level), memory_order_relaxed); }
+    bool enabled(LogLevel level) const {
+        return static_cast<int>(level) >= minLevel.load(memory_order_relaxed);
+    }
+
+    // Queues one line (without its tag or trailing newline)
+    void write(LogLevel level, const char* text, size_t len) {
+        Ring& r = local();
+        len = min(len, MAX_LINE);
+        uint64_t head = r.head.load(memory_order_relaxed);
+        uint64_t need = HEADER_BYTES + len;
+        if (head + need - r.tail.load(memory_order_acquire) > RING_BYTES) {
+            r.dropped.store(r.dropped.load(memory_order_relaxed) + 1, memory_order_relaxed);
+            wake.notify_one();
+            return;
+        }
+        char hdr[HEADER_BYTES];
+        uint32_t len32 = static_cast<uint32_t>(len);
+        memcpy(hdr, &len32, 4);
+        hdr[4] = static_cast<char>(level);
+        r.put(hdr, HEADER_BYTES, head);
+        r.put(text, len, head + HEADER_BYTES);
+        r.head.store(head + need, memory_order_release);
+        if (head + need - r.tail.load(memory_order_relaxed) > RING_BYTES / 2) wake.notify_one();
+    }
+
+private:
+    friend class LogTally;
+    static constexpr size_t HEADER_BYTES = 5;  ///< uint32 length + level
+
+    struct Ring {
+        char data[RING_BYTES];
+        atomic<uint64_t> head{0};      ///< Bytes written (producer)
+        atomic<uint64_t> tail{0};      ///< Bytes consumed (flusher)
+        atomic<uint64_t> dropped{0};   ///< Lines lost to a full ring (producer)
+        atomic<bool>     retired{false};
+        uint64_t reportedDrops = 0;    ///< Flusher only
+
+        void put(const char* p, size_t n, uint64_t at) {
+            size_t off   = at % RING_BYTES;
+            size_t first = min(n, RING_BYTES - off);
+            memcpy(data + off, p, first);
+            memcpy(data, p + first, n - first);
+        }
+        void get(char* p, size_t n, uint64_t at) const {
+            size_t off   = at % RING_BYTES;
+            size_t first = min(n, RING_BYTES - off);
+            memcpy(p, data + off, first);
+            memcpy(p + first, data, n - first);
+        }
+    };
+
+    // Marks the thread's ring retired when the thread exits; the flusher frees it once drained
+    struct Handle {
+        shared_ptr<Ring> ring;
+        ~Handle() {
+            if (ring) ring->retired.store(true, memory_order_release);
+        }
+    };
+
+    Ring& local() {
+        thread_local Handle handle;
+        if (!handle.ring) {
+            handle.ring = make_shared<Ring>();
+            lock_guard<mutex> lock(mtx);
+            rings.push_back(handle.ring);
+            if (!flusher.joinable() && !stopping) flusher = thread(&AsyncLogger::run, this);
+        }
+        return *handle.ring;
+    }
+
+    void run() {
+        auto nextTally = chrono::steady_clock::now() + chrono::seconds(1);
+        unique_lock<mutex> lock(mtx);
+        while (!stopping) {
+            wake.wait_for(lock, chrono::milliseconds(FLUSH_MS));
+            lock.unlock();
+            bool tallies = chrono::steady_clock::now() >= nextTally;
+            if (tallies) nextTally = chrono::steady_clock::now() + chrono::seconds(1);
+            drain(tallies);
+            lock.lock();
+        }
+    }
+
+    // Writes out every ring (and, if withTallies, every pending tally)
+    void drain(bool withTallies);
+
+    atomic<int> minLevel{static_cast<int>(LogLevel::INFO)};
+    mutex mtx;                       ///< Guards rings, tallies, stopping and flusher start
+    mutex drainMtx;                  ///< One drain at a time (flusher or final)
+    condition_variable wake;
+    vector<shared_ptr<Ring>> rings;
+    vector<LogTally*> tallies;
+    bool stopping = false;
+    thread flusher;
+};
+
+/**
+ * A count reported as one aggregated line per second instead of one line per
+ * event, e.g. "[WARN] 12345 malformed TXT line(s) skipped in 37 payload(s)".
+ * add() is one relaxed atomic add; the flusher prints and resets the totals.
+ */
+class LogTally {
+public:
+    LogTally(AsyncLogger& logger, LogLevel level, string what, string per)
+        : owner(logger), level(level), what(move(what)), per(move(per)) {
+        lock_guard<mutex> lock(owner.mtx);
+        owner.tallies.push_back(this);
+    }
+
+    ~LogTally() {
+        {
+            lock_guard<mutex> lock(owner.mtx);
+            owner.tallies.erase(remove(owner.tallies.begin(), owner.tallies.end(), this), owner.tallies.end());
+        }
+        // Report what is left directly; thread rings may already be gone at exit
+        lock_guard<mutex> lock(owner.drainMtx);
+        string line = take();
+        fwrite(line.data(), 1, line.size(), level >= LogLevel::WARN ? stderr : stdout);
+        fflush(level >= LogLevel::WARN ? stderr : stdout);
+    }
+
+    void add(uint64_t n) {
+        count.fetch_add(n, memory_order_relaxed);
+        events.fetch_add(1, memory_order_relaxed);
+    }
+
+    // The pending line (tag included), or "" if nothing was added; resets the totals
+    string take() {
+        uint64_t n = count.exchange(0, memory_order_relaxed);
+        uint64_t e = events.exchange(0, memory_order_relaxed);
+        if (!n && !e) return "";
+        return logLevelTag(level) + to_string(n) + " " + what + " in " + to_string(e) + " " + per + "\n";
+    }
+
+    LogLevel logLevel() const { return level; }
+
+private:
+    AsyncLogger& owner;
+    LogLevel level;
+    string what, per;
+    atomic<uint64_t> count{0}, events{0};
+};
+
+inline void AsyncLogger::drain(bool withTallies) {
+    lock_guard<mutex> drainLock(drainMtx);
+    vector<shared_ptr<Ring>> snapshot;
+    vector<LogTally*> pendingTallies;
+    {
+        lock_guard<mutex> lock(mtx);
+        snapshot = rings;
+        if (withTallies) pendingTallies = tallies;
+    }
+    string out, err;
+    char hdr[HEADER_BYTES];
+    for (const auto& r : snapshot) {
+        bool retired = r->retired.load(memory_order_acquire);  // before head: nothing follows it
+        uint64_t head = r->head.load(memory_order_acquire);
+        uint64_t tail = r->tail.load(memory_order_relaxed);
+        while (tail < head) {
+            r->get(hdr, HEADER_BYTES, tail);
+            uint32_t len;
+            memcpy(&len, hdr, 4);
+            LogLevel level = static_cast<LogLevel>(hdr[4]);
+            string& dst = level >= LogLevel::WARN ? err : out;
+            dst += logLevelTag(level);
+            size_t at = dst.size();
+            dst.resize(at + len);
+            r->get(&dst[at], len, tail + HEADER_BYTES);
+            dst += '\n';
+            tail += HEADER_BYTES + len;
+        }
+        r->tail.store(tail, memory_order_release);
+        uint64_t dropped = r->dropped.load(memory_order_relaxed);
+        if (dropped != r->reportedDrops) {
+            err += string(logLevelTag(LogLevel::WARN)) + "Log buffer full, dropped "
+                 + to_string(dropped - r->reportedDrops) + " line(s)\n";
+            r->reportedDrops = dropped;
+        }
+        if (retired) {
+            lock_guard<mutex> lock(mtx);
+            rings.erase(remove(rings.begin(), rings.end(), r), rings.end());
+        }
+    }
+    for (LogTally* t : pendingTallies) {
+        (t->logLevel() >= LogLevel::WARN ? err : out) += t->take();
+    }
+    if (!out.empty()) {
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+    if (!err.empty()) {
+        fwrite(err.data(), 1, err.size(), stderr);
+        fflush(stderr);
+    }
+}
+
+/**
+ * Formats one line into a per-thread scratch buffer and queues it when the
+ * statement ends. Integers and floats are formatted without iostreams; other
+ * types fall back to operator<< on an ostringstream.
+ */
+class LogLine {
+public:
+    LogLine(AsyncLogger& logger, LogLevel level, uint64_t suppressed = 0)
+        : logger(logger), level(level), suppressed(suppressed), buf(scratch()), start(buf.size()) {}
+
+    ~LogLine() {
+        if (suppressed) *this << " (" << suppressed << " similar line(s) suppressed)";
+        logger.write(level, buf.data() + start, buf.size() - start);
+        buf.resize(start);  // a line built while formatting another nests correctly
+    }
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    template <typename T>
+    LogLine& operator<<(const T& v) {
+        if constexpr (is_same_v<T, bool>) {
+            buf += v ? '1' : '0';
+        } else if constexpr (is_same_v<T, char>) {
+            buf += v;
+        } else if constexpr (is_integral_v<T>) {
+            char tmp[24];
+            buf.append(tmp, to_chars(tmp, tmp + sizeof(tmp), v).ptr);
+        } else if constexpr (is_floating_point_v<T>) {
+            char tmp[32];
+            int n = snprintf(tmp, sizeof(tmp), "%g", static_cast<double>(v));  // as ostream prints it
+            buf.append(tmp, static_cast<size_t>(max(0, min(n, static_cast<int>(sizeof(tmp)) - 1))));
+        } else if constexpr (is_convertible_v<const T&, string_view>) {
+            buf += string_view(v);
+        } else {
+            ostringstream os;
+            os << v;
+            buf += os.str();
+        }
+        return *this;
+    }
+
+private:
+    static string& scratch() {
+        thread_local string s;
+        return s;
+    }
+
+    AsyncLogger& logger;
+    LogLevel level;
+    uint64_t suppressed;
+    string& buf;
+    size_t start;
+};
+
+/**
+ * Lets at most perSecond lines through per wall-clock second; the next line
+ * let through reports how many were suppressed in between.
+ */
+class LogRateLimit {
+public:
+    explicit LogRateLimit(uint32_t perSecond) : limit(perSecond) {}
+
+    bool allow(uint64_t& suppressedOut) {
+        int64_t now = chrono::duration_cast<chrono::seconds>(
+                          chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t current = window.load(memory_order_relaxed);
+        if (now != current && window.compare_exchange_strong(current, now, memory_order_relaxed)) {
+            inWindow.store(0, memory_order_relaxed);
+        }
+        if (inWindow.fetch_add(1, memory_order_relaxed) < limit) {
+            suppressedOut = suppressed.exchange(0, memory_order_relaxed);
+            return true;
+        }
+        suppressed.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+private:
+    uint32_t limit;
+    atomic<int64_t>  window{0};
+    atomic<uint32_t> inWindow{0};
+    atomic<uint64_t> suppressed{0};
+};
+
+// The process-wide logger
+inline AsyncLogger asyncLogger;
+
+// LOG(INFO) << "Parsed " << n << " records";  -- arguments are not evaluated below the level
+#define LOG(level) \
+    if (!asyncLogger.enabled(LogLevel::level)) {} else LogLine(asyncLogger, LogLevel::level)
+
+// LOG(level) limited to perSecond lines per second at this call site
+#define LOG_EVERY(level, perSecond)                                                              \
+    if (uint64_t logSuppressed_ = 0; !asyncLogger.enabled(LogLevel::level) ||                     \
+        ![]() -> LogRateLimit& { static LogRateLimit limit(perSecond); return limit; }()          \
+                     .allow(logSuppressed_)) {}                                                   \
+    else LogLine(asyncLogger, LogLevel::level, logSuppressed_)
+
+#endif // ASYNC_LOGGER_HPP
@@ -0,0 +1,595 @@
+// File: server/util/regex_dfa.hpp
+// RegexDFA: Linear-time regular expression search using a lazily built, memory-capped DFA.
+
+#ifndef REGEX_DFA_HPP
+#define REGEX_DFA_HPP
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Search ("does the text contain a match") for a backtracking-free regex
+ * subset: literals, '.', [classes] with ranges and negation, \d \w \s (and
+ * \D \W \S), \t \n \r \xHH, groups (...) and (?:...), '|', the quantifiers
+ * * + ? {m} {m,} {m,n} (a trailing lazy '?' is accepted and ignored), and the
+ * anchors ^ $. Backreferences and lookaround are rejected.
+ *
+ * The pattern is compiled once into a Thompson NFA. DFA states (sets of NFA
+ * states) are created on demand the first time a transition is taken and
+ * cached, over byte classes rather than all 256 bytes. When the cache
+ * outgrows its memory cap it is flushed and rebuilt as needed, so memory is
+ * bounded and every input byte costs at most one subset construction: total
+ * time is linear in the text for any pattern.
+ *
+ * If every match must contain some literal, that literal is checked first
+ * with a plain substring search and texts without it are rejected at once.
+ *
+ * The cache is mutated while matching, so one instance must not be shared
+ * between threads.
+ */
+class RegexDFA {
+public:
+    static constexpr size_t MAX_NFA_STATES   = 10000;
+    static constexpr int    MAX_REPEAT       = 1000;
+    static constexpr int    MAX_NESTING      = 64;    ///< Groups plus stacked quantifiers
+    static constexpr size_t DEFAULT_CACHE_BYTES = 2u << 20;
+
+    /**
+     * Compiles a pattern.
+     * @param pattern    Regex source.
+     * @param err        Set to the reason when compilation fails.
+     * @param cacheBytes Memory cap for cached DFA states.
+     * @return false if the pattern is invalid or too large.
+     */
+    bool compile(const string& pattern, string& err, size_t cacheBytes = DEFAULT_CACHE_BYTES) {
+        src = pattern;
+        pos = 0;
+        depth = 0;
+        error.clear();
+        nodes.clear();
+        nfa.clear();
+        sets.clear();
+        cacheCap = cacheBytes;
+
+        int root = parseAlt();
+        if (error.empty() && pos < src.size()) setError("unmatched ')'");
+        if (!error.empty()) {
+            err = error + " at offset " + to_string(pos);
+            return false;
+        }
+        prefilter = requiredLiteral(root);
+
+        int match = addState({NState::MATCH});
+        startNfa  = compileNode(root, match);
+        if (nfa.size() > MAX_NFA_STATES) {
+            err = "pattern too large";
+            return false;
+        }
+        buildClasses();
+        restart = closure({startNfa}, false, false);
+        flushCache();
+        return true;
+    }
+
+    // True if some substring of text matches the pattern
+    bool search(string_view text) {
+        if (!prefilter.empty() && text.find(prefilter) == string_view::npos) return false;
+        int s = startState();
+        if (states[s].match) return true;
+        for (unsigned char b : text) {
+            int t = trans[static_cast<size_t>(s) * classes + classOf[b]];
+            if (t < 0) t = computeTransition(s, classOf[b]);
+            s = t;
+            if (states[s].match) return true;
+            if (states[s].dead) return false;
+        }
+        return states[s].matchAtEnd;
+    }
+
+    // Literal every match contains ("" if none); used as the prefilter
+    const string& requiredLiteralText() const { return prefilter; }
+
+    // Times the DFA cache was flushed for exceeding its cap
+    uint64_t cacheFlushes() const { return flushes; }
+
+private:
+    // ---- Syntax tree ------------------------------------------------------
+
+    struct Node {
+        enum Type { EMPTY, SET, CONCAT, ALT, REPEAT, BEGIN, END } type;
+        int set = -1;               ///< SET: index into sets
+        vector<int> kids;           ///< CONCAT, ALT, REPEAT (one child)
+        int minRep = 0, maxRep = 0; ///< REPEAT bounds; maxRep -1 = unbounded
+
+        Node(Type t) : type(t) {}
+    };
+
+    int addNode(Node n) {
+        nodes.push_back(move(n));
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    int setNode(const bitset<256>& bits) {
+        sets.push_back(bits);
+        Node n{Node::SET};
+        n.set = static_cast<int>(sets.size()) - 1;
+        return addNode(n);
+    }
+
+    void setError(const string& msg) {
+        if (error.empty()) error = msg;
+    }
+
+    bool more() const { return pos < src.size() && error.empty(); }
+
+    int parseAlt() {
+        vector<int> alts{parseConcat()};
+        while (more() && src[pos] == '|') {
+            ++pos;
+            alts.push_back(parseConcat());
+        }
+        if (alts.size() == 1) return alts[0];
+        Node n{Node::ALT};
+        n.kids = alts;
+        return addNode(n);
+    }
+
+    int parseConcat() {
+        Node n{Node::CONCAT};
+        while (more() && src[pos] != '|' && src[pos] != ')') n.kids.push_back(parseRepeat());
+        if (n.kids.empty()) return addNode({Node::EMPTY});
+        if (n.kids.size() == 1) return n.kids[0];
+        return addNode(n);
+    }
+
+    // Every group and quantifier adds a level to the recursive compile and
+    // analysis passes, so their nesting is capped here before any recursion
+    bool enter() {
+        if (++depth <= MAX_NESTING) return true;
+        setError("pattern nested too deeply");
+        return false;
+    }
+
+    int parseRepeat() {
+        int atom = parseAtom();
+        int outer = depth;
+        while (more()) {
+            char c = src[pos];
+            int lo, hi;
+            if (c == '*')      { lo = 0; hi = -1; ++pos; }
+            else if (c == '+') { lo = 1; hi = -1; ++pos; }
+            else if (c == '?') { lo = 0; hi = 1;  ++pos; }
+            else if (c == '{' && parseBraces(lo, hi)) {}
+            else break;
+            if (!enter()) break;
+            if (pos < src.size() && src[pos] == '?') ++pos;  // lazy: same yes/no answer
+            Node n{Node::REPEAT};
+            n.kids   = {atom};
+            n.minRep = lo;
+            n.maxRep = hi;
+            atom = addNode(n);
+        }
+        depth = outer;
+        return atom;
+    }
+
+    // "{m}", "{m,}" or "{m,n}" at pos; leaves pos alone if it is not a quantifier
+    bool parseBraces(int& lo, int& hi) {
+        size_t p = pos + 1;
+        auto number = [&](int& v) {
+            size_t start = p;
+            v = 0;
+            while (p < src.size() && src[p] >= '0' && src[p] <= '9' && v <= MAX_REPEAT) {
+                v = v * 10 + (src[p++] - '0');
+            }
+            return p > start;
+        };
+        if (!number(lo)) return false;
+        hi = lo;
+        if (p < src.size() && src[p] == ',') {
+            ++p;
+            if (!number(hi)) hi = -1;
+        }
+        if (p >= src.size() || src[p] != '}') return false;
+        if (lo > MAX_REPEAT || hi > MAX_REPEAT || (hi >= 0 && hi < lo)) {
+            setError("invalid repetition bounds");
+            return false;
+        }
+        pos = p + 1;
+        return true;
+    }
+
+    int parseAtom() {
+        char c = src[pos++];
+        switch (c) {
+            case '(': {
+                if (src.compare(pos, 2, "?:") == 0) {
+                    pos += 2;
+                } else if (pos < src.size() && src[pos] == '?') {
+                    setError("unsupported group syntax");
+                    return addNode({Node::EMPTY});
+                }
+                if (!enter()) return addNode({Node::EMPTY});
+                int inner = parseAlt();
+                --depth;
+                if (pos >= src.size() || src[pos] != ')') setError("missing ')'");
+                else ++pos;
+                return inner;
+            }
+            case '[': return parseClass();
+            case '.': {
+                bitset<256> any;
+                any.set();
+                any.reset('\n');
+                return setNode(any);
+            }
+            case '^': return addNode({Node::BEGIN});
+            case '$': return addNode({Node::END});
+            case '\\': {
+                bitset<256> bits;
+                if (!parseEscape(bits)) return addNode({Node::EMPTY});
+                return setNode(bits);
+            }
+            case '*': case '+': case '?': case '{':
+                setError("quantifier without operand");
+                return addNode({Node::EMPTY});
+            default: {
+                bitset<256> bits;
+                bits.set(static_cast<unsigned char>(c));
+                return setNode(bits);
+            }
+        }
+    }
+
+    // Escape after '\' (already consumed) as a byte set
+    bool parseEscape(bitset<256>& bits) {
+        if (pos >= src.size()) {
+            setError("trailing backslash");
+            return false;
+        }
+        char c = src[pos++];
+        auto range = [&](int a, int b) { for (int i = a; i <= b; ++i) bits.set(i); };
+        switch (c) {
+            case 'd': case 'D': range('0', '9'); break;
+            case 'w': case 'W': range('0', '9'); range('a', 'z'); range('A', 'Z'); bits.set('_'); break;
+            case 's': case 'S': for (char w : string(" \t\n\r\f\v")) bits.set(static_cast<unsigned char>(w)); break;
+            case 't': bits.set('\t'); return true;
+            case 'n': bits.set('\n'); return true;
+            case 'r': bits.set('\r'); return true;
+            case 'x': {
+                auto hex = [](char h) {
+                    if (h >= '0' && h <= '9') return h - '0';
+                    if (h >= 'a' && h <= 'f') return h - 'a' + 10;
+                    if (h >= 'A' && h <= 'F') return h - 'A' + 10;
+                    return -1;
+                };
+                if (pos + 2 > src.size() || hex(src[pos]) < 0 || hex(src[pos + 1]) < 0) {
+                    setError("invalid \\x escape");
+                    return false;
+                }
+                bits.set(static_cast<size_t>(hex(src[pos]) * 16 + hex(src[pos + 1])));
+                pos += 2;
+                return true;
+            }
+            default:
+                if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+                    setError(string("unsupported escape \\") + c);
+                    return false;
+                }
+                bits.set(static_cast<unsigned char>(c));
+                return true;
+        }
+        if (c == 'D' || c == 'W' || c == 'S') bits.flip();
+        return true;
+    }
+
+    int parseClass() {
+        bitset<256> bits;
+        bool negate = pos < src.size() && src[pos] == '^';
+        if (negate) ++pos;
+        bool first = true;
+        while (error.empty()) {
+            if (pos >= src.size()) {
+                setError("missing ']'");
+                break;
+            }
+            char c = src[pos];
+            if (c == ']' && !first) {
+                ++pos;
+                break;
+            }
+            first = false;
+            ++pos;
+            if (c == '\\') {
+                bitset<256> esc;
+                if (!parseEscape(esc)) break;
+                bits |= esc;
+                continue;
+            }
+            unsigned char lo = static_cast<unsigned char>(c), hi = lo;
+            if (pos + 1 < src.size() && src[pos] == '-' && src[pos + 1] != ']') {
+                hi = static_cast<unsigned char>(src[pos + 1]);
+                pos += 2;
+                if (hi < lo) {
+                    setError("invalid class range");
+                    break;
+                }
+            }
+            for (unsigned v = lo; v <= hi; ++v) bits.set(v);
+        }
+        if (negate) bits.flip();
+        return setNode(bits);
+    }
+
+    /**
+     * Longest literal that occurs in every match: runs of single-byte sets in
+     * a concatenation, or the best literal of a mandatory sub-expression.
+     * Alternations and optional parts contribute nothing.
+     */
+    string requiredLiteral(int i) const {
+        const Node& n = nodes[i];
+        auto single = [&](const Node& k, unsigned char& out) {
+            if (k.type != Node::SET || sets[k.set].count() != 1) return false;
+            for (unsigned v = 0; v < 256; ++v) {
+                if (sets[k.set].test(v)) out = static_cast<unsigned char>(v);
+            }
+            return true;
+        };
+        switch (n.type) {
+            case Node::SET: {
+                unsigned char c = 0;
+                return single(n, c) ? string(1, static_cast<char>(c)) : string();
+            }
+            case Node::REPEAT:
+                return n.minRep >= 1 ? requiredLiteral(n.kids[0]) : string();
+            case Node::ALT:
+                return n.kids.size() == 1 ? requiredLiteral(n.kids[0]) : string();
+            case Node::CONCAT: {
+                string best, run;
+                for (int k : n.kids) {
+                    unsigned char c = 0;
+                    const Node& kid = nodes[k];
+                    if (kid.type == Node::BEGIN || kid.type == Node::END) continue;
+                    if (single(kid, c)) {
+                        run += static_cast<char>(c);
+                        continue;
+                    }
+                    if (run.size() > best.size()) best = run;
+                    run.clear();
+                    string inner = requiredLiteral(k);
+                    if (inner.size() > best.size()) best = inner;
+                }
+                return run.size() > best.size() ? run : best;
+            }
+            default:
+                return string();
+        }
+    }
+
+    // ---- Thompson NFA -----------------------------------------------------
+
+    struct NState {
+        enum Type { SET, SPLIT, MATCH, BEGIN, END } type;
+        int set = -1;          ///< SET: byte set index
+        int out = -1, out1 = -1;
+
+        NState(Type t, int s = -1, int o = -1, int o1 = -1) : type(t), set(s), out(o), out1(o1) {}
+    };
+
+    int addState(NState s) {
+        nfa.push_back(s);
+        return static_cast<int>(nfa.size()) - 1;
+    }
+
+    // Compiles node i so that it continues into state next; returns its entry state
+    int compileNode(int i, int next) {
+        if (nfa.size() > MAX_NFA_STATES) return next;  // abandoned; compile() reports it
+        const Node n = nodes[i];
+        switch (n.type) {
+            case Node::EMPTY:  return next;
+            case Node::BEGIN:  return addState({NState::BEGIN, -1, next});
+            case Node::END:    return addState({NState::END, -1, next});
+            case Node::SET:    return addState({NState::SET, n.set, next});
+            case Node::CONCAT:
+                for (size_t k = n.kids.size(); k-- > 0;) next = compileNode(n.kids[k], next);
+                return next;
+            case Node::ALT: {
+                int entry = compileNode(n.kids.back(), next);
+                for (size_t k = n.kids.size() - 1; k-- > 0;) {
+                    int alt = compileNode(n.kids[k], next);
+                    entry = addState({NState::SPLIT, -1, alt, entry});
+                }
+                return entry;
+            }
+            case Node::REPEAT:
+            default: {
+                int tail = next;
+                if (n.maxRep < 0) {
+                    // x*: loop state that either enters x (which returns to it) or leaves
+                    int loop = addState({NState::SPLIT, -1, -1, next});
+                    nfa[loop].out = compileNode(n.kids[0], loop);
+                    tail = loop;
+                } else {
+                    // (x(x(...)?)?)? for the optional copies
+                    for (int k = n.minRep; k < n.maxRep; ++k) {
+                        int body = compileNode(n.kids[0], tail);
+                        tail = addState({NState::SPLIT, -1, body, next});
+                    }
+                }
+                for (int k = 0; k < n.minRep; ++k) tail = compileNode(n.kids[0], tail);
+                return tail;
+            }
+        }
+    }
+
+    /**
+     * Epsilon closure of seeds: SPLITs are followed, BEGIN/END only when the
+     * position allows. Only SET, MATCH and (mid-text) END states are kept,
+     * sorted, as they are all a DFA state needs.
+     */
+    vector<int> closure(const vector<int>& seeds, bool atBegin, bool atEnd) {
+        if (seen.size() != nfa.size()) seen.assign(nfa.size(), 0);
+        if (++stamp == 0) {
+            fill(seen.begin(), seen.end(), 0);
+            stamp = 1;
+        }
+        vector<int> out;
+        stack.assign(seeds.begin(), seeds.end());
+        while (!stack.empty()) {
+            int s = stack.back();
+            stack.pop_back();
+            if (s < 0 || seen[s] == stamp) continue;
+            seen[s] = stamp;
+            const NState& st = nfa[s];
+            switch (st.type) {
+                case NState::SPLIT:
+                    stack.push_back(st.out1);
+                    stack.push_back(st.out);
+                    break;
+                case NState::BEGIN:
+                    if (atBegin) stack.push_back(st.out);
+                    break;
+                case NState::END:
+                    if (atEnd) stack.push_back(st.out);
+                    else       out.push_back(s);
+                    break;
+                default:
+                    out.push_back(s);
+                    break;
+            }
+        }
+        sort(out.begin(), out.end());
+        return out;
+    }
+
+    // Partition bytes into classes that every byte set treats alike
+    void buildClasses() {
+        map<vector<bool>, uint16_t> ids;
+        for (unsigned b = 0; b < 256; ++b) {
+            vector<bool> sig(sets.size());
+            for (size_t k = 0; k < sets.size(); ++k) sig[k] = sets[k].test(b);
+            auto it = ids.emplace(sig, static_cast<uint16_t>(ids.size())).first;
+            classOf[b]  = it->second;
+            if (it->second == classRep.size()) classRep.push_back(static_cast<unsigned char>(b));
+        }
+        classes = ids.size();
+    }
+
+    // ---- Lazy DFA ---------------------------------------------------------
+
+    struct DState {
+        vector<int> nfaStates;
+        bool match      = false;  ///< A match ends here
+        bool matchAtEnd = false;  ///< A match ends here if the text ends here
+        bool dead       = false;  ///< No match can follow
+    };
+
+    void flushCache() {
+        if (!states.empty()) ++flushes;
+        states.clear();
+        trans.clear();
+        index.clear();
+        cacheUsed = 0;
+        startId = -1;
+    }
+
+    // DFA state for an NFA set (keyed with whether it is the start position)
+    int intern(vector<int> set, bool atBegin) {
+        vector<int> key = set;
+        if (atBegin) key.push_back(-1);
+        auto it = index.find(key);
+        if (it != index.end()) return it->second;
+
+        size_t cost = classes * sizeof(int32_t) + 2 * set.size() * sizeof(int) + 64;
+        if (cacheUsed + cost > cacheCap && !states.empty()) flushCache();
+        cacheUsed += cost;
+
+        DState d;
+        d.match = binary_search(set.begin(), set.end(), matchState());
+        d.matchAtEnd = d.match;
+        bool hasEnd = any_of(set.begin(), set.end(), [&](int n) { return nfa[n].type == NState::END; });
+        if (!d.match && hasEnd) {
+            vector<int> atEndSet = closure(set, atBegin, true);
+            d.matchAtEnd = binary_search(atEndSet.begin(), atEndSet.end(), matchState());
+        }
+        d.dead = set.empty() && restart.empty();
+        d.nfaStates = move(set);
+        states.push_back(move(d));
+        trans.resize(trans.size() + classes, -1);
+        int id = static_cast<int>(states.size()) - 1;
+        index.emplace(move(key), id);
+        return id;
+    }
+
+    int startState() {
+        if (startId < 0) startId = intern(closure({startNfa}, true, false), true);
+        return startId;
+    }
+
+    // Follows class c from DFA state s, building the target state if needed
+    int computeTransition(int s, uint16_t c) {
+        unsigned char byte = classRep[c];
+        vector<int> seeds(restart);  // unanchored search: a match may start anywhere
+        for (int n : states[s].nfaStates) {
+            const NState& st = nfa[n];
+            if (st.type == NState::SET && sets[st.set].test(byte)) seeds.push_back(st.out);
+        }
+        size_t before = flushes;
+        int t = intern(closure(seeds, false, false), false);
+        // After a flush s no longer exists; t is valid in the new cache
+        if (flushes == before) trans[static_cast<size_t>(s) * classes + c] = t;
+        return t;
+    }
+
+    // The MATCH state is always the first NFA state created
+    static int matchState() { return 0; }
+
+    // Parser state
+    string src;
+    size_t pos = 0;
+    int depth = 0;         ///< Open groups and stacked quantifiers at pos
+    string error;
+    vector<Node> nodes;
+
+    // Compiled pattern
+    vector<bitset<256>> sets;
+    vector<NState> nfa;
+    int startNfa = 0;
+    vector<int> restart;               ///< Closure of the start state mid-text
+    string prefilter;
+    uint16_t classOf[256] = {};
+    vector<unsigned char> classRep;    ///< A representative byte per class
+    size_t classes = 1;
+
+    // Scratch space for closure(), reused to avoid per-byte allocations
+    vector<uint32_t> seen;             ///< == stamp: visited in the current closure
+    uint32_t stamp = 0;
+    vector<int> stack;
+
+    // DFA cache
+    vector<DState> states;
+    vector<int32_t> trans;             ///< [state * classes + class], -1 = not built
+    struct SetHash {
+        size_t operator()(const vector<int>& v) const {
+            size_t h = v.size();
+            for (int x : v) h = h * 1000003u ^ static_cast<size_t>(x);
+            return h;
+        }
+    };
+    unordered_map<vector<int>, int, SetHash> index;
+    size_t cacheCap  = DEFAULT_CACHE_BYTES;
+    size_t cacheUsed = 0;
+    int    startId   = -1;
+    uint64_t flushes = 0;
+};
+
+#endif // REGEX_DFA_HPP
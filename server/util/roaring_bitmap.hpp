@@ -0,0 +1,288 @@
+// File: server/util/roaring_bitmap.hpp
+// RoaringBitmap: Compressed set of uint32 record positions (Roaring layout:
+// 16-bit high key -> sorted array or 65536-bit bitmap container).
+
+#ifndef ROARING_BITMAP_HPP
+#define ROARING_BITMAP_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Each 2^16 range of values is one container. Sparse containers hold a
+ * sorted uint16 array; once a container exceeds ARRAY_MAX values it becomes
+ * a fixed 8 KB bitmap. AND/OR work container by container, so combining two
+ * indexes costs time proportional to their compressed size.
+ */
+class RoaringBitmap {
+public:
+    // Adds a value; fastest when values arrive in ascending order
+    void add(uint32_t v) {
+        Container& c = containerFor(static_cast<uint16_t>(v >> 16));
+        uint16_t low = static_cast<uint16_t>(v);
+        if (c.isBitmap) {
+            uint64_t& w = c.bits[low >> 6];
+            uint64_t m = 1ULL << (low & 63);
+            if (!(w & m)) {
+                w |= m;
+                ++c.card;
+            }
+            return;
+        }
+        if (c.array.empty() || c.array.back() < low) {
+            c.array.push_back(low);
+        } else {
+            auto it = lower_bound(c.array.begin(), c.array.end(), low);
+            if (it != c.array.end() && *it == low) return;
+            c.array.insert(it, low);
+        }
+        c.card = static_cast<uint32_t>(c.array.size());
+        if (c.card > ARRAY_MAX) toBitmap(c);
+    }
+
+    bool contains(uint32_t v) const {
+        const Container* c = find(static_cast<uint16_t>(v >> 16));
+        if (!c) return false;
+        uint16_t low = static_cast<uint16_t>(v);
+        if (c->isBitmap) return c->bits[low >> 6] & (1ULL << (low & 63));
+        return binary_search(c->array.begin(), c->array.end(), low);
+    }
+
+    uint64_t cardinality() const {
+        uint64_t n = 0;
+        for (const auto& c : containers) n += c.card;
+        return n;
+    }
+
+    bool empty() const { return containers.empty(); }
+
+    // Approximate heap footprint in bytes
+    size_t memoryBytes() const {
+        size_t n = containers.capacity() * sizeof(Container);
+        for (const auto& c : containers) {
+            n += c.array.capacity() * sizeof(uint16_t) + c.bits.capacity() * sizeof(uint64_t);
+        }
+        return n;
+    }
+
+    // Calls fn(value) for every value in ascending order
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& c : containers) {
+            uint32_t high = static_cast<uint32_t>(c.key) << 16;
+            if (c.isBitmap) {
+                for (uint32_t w = 0; w < BITMAP_WORDS; ++w) {
+                    uint64_t word = c.bits[w];
+                    while (word) {
+                        uint32_t bit = static_cast<uint32_t>(__builtin_ctzll(word));
+                        fn(high | (w << 6 | bit));
+                        word &= word - 1;
+                    }
+                }
+            } else {
+                for (uint16_t low : c.array) fn(high | low);
+            }
+        }
+    }
+
+    // Intersection
+    static RoaringBitmap andOf(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap out;
+        size_t i = 0, j = 0;
+        while (i < a.containers.size() && j < b.containers.size()) {
+            const Container& x = a.containers[i];
+            const Container& y = b.containers[j];
+            if (x.key < y.key) { ++i; continue; }
+            if (y.key < x.key) { ++j; continue; }
+            Container c = andContainers(x, y);
+            if (c.card > 0) out.containers.push_back(move(c));
+            ++i;
+            ++j;
+        }
+        return out;
+    }
+
+    // Union
+    static RoaringBitmap orOf(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap out;
+        size_t i = 0, j = 0;
+        while (i < a.containers.size() || j < b.containers.size()) {
+            if (j == b.containers.size() ||
+                (i < a.containers.size() && a.containers[i].key < b.containers[j].key)) {
+                out.containers.push_back(a.containers[i++]);
+            } else if (i == a.containers.size() || b.containers[j].key < a.containers[i].key) {
+                out.containers.push_back(b.containers[j++]);
+            } else {
+                out.containers.push_back(orContainers(a.containers[i++], b.containers[j++]));
+            }
+        }
+        return out;
+    }
+
+    /**
+     * Appends the bitmap to out:
+     * uint32 containerCount, then per container uint16 key, uint8 isBitmap,
+     * uint32 cardinality and either cardinality x uint16 or 1024 x uint64.
+     */
+    void serialize(string& out) const {
+        put(out, static_cast<uint32_t>(containers.size()));
+        for (const auto& c : containers) {
+            put(out, c.key);
+            out.push_back(static_cast<char>(c.isBitmap));
+            put(out, c.card);
+            if (c.isBitmap) {
+                out.append(reinterpret_cast<const char*>(c.bits.data()), BITMAP_WORDS * sizeof(uint64_t));
+            } else {
+                out.append(reinterpret_cast<const char*>(c.array.data()), c.array.size() * sizeof(uint16_t));
+            }
+        }
+    }
+
+    // Reads a bitmap written by serialize; advances p. Returns false on malformed input.
+    bool deserialize(const uint8_t*& p, const uint8_t* end) {
+        containers.clear();
+        uint32_t count;
+        if (!get(p, end, count)) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            Container c;
+            uint8_t isBitmap;
+            if (!get(p, end, c.key) || !get(p, end, isBitmap) || !get(p, end, c.card)) return false;
+            c.isBitmap = isBitmap != 0;
+            if (c.isBitmap) {
+                if (static_cast<size_t>(end - p) < BITMAP_WORDS * sizeof(uint64_t)) return false;
+                c.bits.resize(BITMAP_WORDS);
+                memcpy(c.bits.data(), p, BITMAP_WORDS * sizeof(uint64_t));
+                p += BITMAP_WORDS * sizeof(uint64_t);
+            } else {
+                if (c.card > ARRAY_MAX || static_cast<size_t>(end - p) < c.card * sizeof(uint16_t)) return false;
+                c.array.resize(c.card);
+                memcpy(c.array.data(), p, c.card * sizeof(uint16_t));
+                p += c.card * sizeof(uint16_t);
+            }
+            containers.push_back(move(c));
+        }
+        return true;
+    }
+
+private:
+    static constexpr uint32_t ARRAY_MAX    = 4096;   ///< Above this an array is larger than a bitmap
+    static constexpr uint32_t BITMAP_WORDS = 1024;   ///< 65536 bits
+
+    struct Container {
+        uint16_t key = 0;
+        bool isBitmap = false;
+        uint32_t card = 0;
+        vector<uint16_t> array;  ///< Sorted low halves (array container)
+        vector<uint64_t> bits;   ///< 65536-bit set (bitmap container)
+    };
+
+    template <typename T>
+    static void put(string& out, T v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+    template <typename T>
+    static bool get(const uint8_t*& p, const uint8_t* end, T& v) {
+        if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    const Container* find(uint16_t key) const {
+        auto it = lower_bound(containers.begin(), containers.end(), key,
+                              [](const Container& c, uint16_t k) { return c.key < k; });
+        return (it != containers.end() && it->key == key) ? &*it : nullptr;
+    }
+
+    Container& containerFor(uint16_t key) {
+        if (!containers.empty() && containers.back().key == key) return containers.back();
+        auto it = lower_bound(containers.begin(), containers.end(), key,
+                              [](const Container& c, uint16_t k) { return c.key < k; });
+        if (it != containers.end() && it->key == key) return *it;
+        Container c;
+        c.key = key;
+        return *containers.insert(it, move(c));
+    }
+
+    static void toBitmap(Container& c) {
+        c.bits.assign(BITMAP_WORDS, 0);
+        for (uint16_t low : c.array) c.bits[low >> 6] |= 1ULL << (low & 63);
+        c.array.clear();
+        c.array.shrink_to_fit();
+        c.isBitmap = true;
+    }
+
+    static void toArray(Container& c) {
+        c.array.clear();
+        c.array.reserve(c.card);
+        for (uint32_t w = 0; w < BITMAP_WORDS; ++w) {
+            uint64_t word = c.bits[w];
+            while (word) {
+                c.array.push_back(static_cast<uint16_t>(w << 6 | __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+        c.bits.clear();
+        c.bits.shrink_to_fit();
+        c.isBitmap = false;
+    }
+
+    static Container andContainers(const Container& x, const Container& y) {
+        Container c;
+        c.key = x.key;
+        if (x.isBitmap && y.isBitmap) {
+            c.isBitmap = true;
+            c.bits.resize(BITMAP_WORDS);
+            for (uint32_t w = 0; w < BITMAP_WORDS; ++w) {
+                c.bits[w] = x.bits[w] & y.bits[w];
+                c.card += static_cast<uint32_t>(__builtin_popcountll(c.bits[w]));
+            }
+            if (c.card <= ARRAY_MAX) toArray(c);
+        } else if (x.isBitmap || y.isBitmap) {
+            const Container& arr = x.isBitmap ? y : x;
+            const Container& bm  = x.isBitmap ? x : y;
+            for (uint16_t low : arr.array) {
+                if (bm.bits[low >> 6] & (1ULL << (low & 63))) c.array.push_back(low);
+            }
+            c.card = static_cast<uint32_t>(c.array.size());
+        } else {
+            set_intersection(x.array.begin(), x.array.end(), y.array.begin(), y.array.end(),
+                             back_inserter(c.array));
+            c.card = static_cast<uint32_t>(c.array.size());
+        }
+        return c;
+    }
+
+    static Container orContainers(const Container& x, const Container& y) {
+        Container c;
+        c.key = x.key;
+        if (!x.isBitmap && !y.isBitmap) {
+            set_union(x.array.begin(), x.array.end(), y.array.begin(), y.array.end(),
+                      back_inserter(c.array));
+            c.card = static_cast<uint32_t>(c.array.size());
+            if (c.card > ARRAY_MAX) toBitmap(c);
+            return c;
+        }
+        c.isBitmap = true;
+        c.bits.assign(BITMAP_WORDS, 0);
+        for (const Container* src : {&x, &y}) {
+            if (src->isBitmap) {
+                for (uint32_t w = 0; w < BITMAP_WORDS; ++w) c.bits[w] |= src->bits[w];
+            } else {
+                for (uint16_t low : src->array) c.bits[low >> 6] |= 1ULL << (low & 63);
+            }
+        }
+        for (uint32_t w = 0; w < BITMAP_WORDS; ++w) {
+            c.card += static_cast<uint32_t>(__builtin_popcountll(c.bits[w]));
+        }
+        return c;
+    }
+
+    vector<Container> containers;  ///< Sorted by key
+};
+
+#endif // ROARING_BITMAP_HPP
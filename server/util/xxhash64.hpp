@@ -0,0 +1,144 @@
+// File: server/util/xxhash64.hpp
+// XXHash64: Fast non-cryptographic 64-bit hash (XXH64 algorithm), one-shot and streaming.
+
+#ifndef XXHASH64_HPP
+#define XXHASH64_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+using namespace std;
+
+/**
+ * Streaming XXH64. Feed data with update() in chunks of any size;
+ * digest() can be called at any point without disturbing the state,
+ * so a copy of the object doubles as a resumable checkpoint.
+ */
+class XXHash64 {
+public:
+    explicit XXHash64(uint64_t seed = 0) { reset(seed); }
+
+    void reset(uint64_t seed = 0) {
+        v1 = seed + P1 + P2;
+        v2 = seed + P2;
+        v3 = seed;
+        v4 = seed - P1;
+        this->seed = seed;
+        total = 0;
+        bufLen = 0;
+    }
+
+    void update(const void* data, size_t len) {
+        const uint8_t* p   = static_cast<const uint8_t*>(data);
+        const uint8_t* end = p + len;
+        total += len;
+
+        // Complete a partially filled stripe first
+        if (bufLen + len < 32) {
+            memcpy(buf + bufLen, p, len);
+            bufLen += static_cast<uint32_t>(len);
+            return;
+        }
+        if (bufLen > 0) {
+            size_t fill = 32 - bufLen;
+            memcpy(buf + bufLen, p, fill);
+            consumeStripe(buf);
+            p += fill;
+            bufLen = 0;
+        }
+        while (p + 32 <= end) {
+            consumeStripe(p);
+            p += 32;
+        }
+        if (p < end) {
+            bufLen = static_cast<uint32_t>(end - p);
+            memcpy(buf, p, bufLen);
+        }
+    }
+
+    void update(string_view s) { update(s.data(), s.size()); }
+
+    uint64_t digest() const {
+        uint64_t h;
+        if (total >= 32) {
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(h, v1);
+            h = mergeRound(h, v2);
+            h = mergeRound(h, v3);
+            h = mergeRound(h, v4);
+        } else {
+            h = seed + P5;
+        }
+        h += total;
+
+        const uint8_t* p   = buf;
+        const uint8_t* end = buf + bufLen;
+        while (p + 8 <= end) {
+            h ^= round(0, read64(p));
+            h  = rotl(h, 27) * P1 + P4;
+            p += 8;
+        }
+        if (p + 4 <= end) {
+            h ^= static_cast<uint64_t>(read32(p)) * P1;
+            h  = rotl(h, 23) * P2 + P3;
+            p += 4;
+        }
+        while (p < end) {
+            h ^= (*p++) * P5;
+            h  = rotl(h, 11) * P1;
+        }
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    // Total number of bytes hashed so far
+    uint64_t length() const { return total; }
+
+    // One-shot convenience
+    static uint64_t hash(const void* data, size_t len, uint64_t seed = 0) {
+        XXHash64 h(seed);
+        h.update(data, len);
+        return h.digest();
+    }
+
+private:
+    static constexpr uint64_t P1 = 11400714785074694791ULL;
+    static constexpr uint64_t P2 = 14029467366897019727ULL;
+    static constexpr uint64_t P3 =  1609587929392839161ULL;
+    static constexpr uint64_t P4 =  9650029242287828579ULL;
+    static constexpr uint64_t P5 =  2870177450012600261ULL;
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t read64(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+    static uint32_t read32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+    static uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * P2;
+        acc  = rotl(acc, 31);
+        return acc * P1;
+    }
+    static uint64_t mergeRound(uint64_t acc, uint64_t val) {
+        acc ^= round(0, val);
+        return acc * P1 + P4;
+    }
+
+    void consumeStripe(const uint8_t* p) {
+        v1 = round(v1, read64(p));
+        v2 = round(v2, read64(p + 8));
+        v3 = round(v3, read64(p + 16));
+        v4 = round(v4, read64(p + 24));
+    }
+
+    uint64_t v1, v2, v3, v4;
+    uint64_t seed;
+    uint64_t total;
+    uint8_t  buf[32];
+    uint32_t bufLen;
+};
+
+#endif // XXHASH64_HPP